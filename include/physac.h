@@ -21,14 +21,22 @@
 *       internal symbols and functions will only be visible inside that file.
 *
 *   #define PHYSAC_NO_THREADS
-*       The generated implementation won't include pthread library and user must create a secondary thread to call PhysicsThread().
-*       It is so important that the thread where PhysicsThread() is called must not have v-sync or any other CPU limitation.
+*       The generated implementation won't create a physics loop thread per world and user must call RunPhysicsStep() from its own loop.
+*       It is so important that the thread where RunPhysicsStep() is called must not have v-sync or any other CPU limitation.
+*
+*   #define PHYSAC_NO_WORKERS
+*       Contact islands of a step are always solved one after another on the stepping thread.
+*       By default a pool of worker threads, one per physical core up to PHYSAC_MAX_WORKERS, solves them in parallel.
 *
 *   #define PHYSAC_STANDALONE
 *       Avoid raylib.h header inclusion in this file. Data types defined on raylib are defined
 *       internally in the library and input management and drawing functions must be provided by
 *       the user (check library implementation for further details).
 *
+*   #define PHYSAC_NO_SIMD
+*       Integration kernels use the scalar fallback even when SSE2 or AVX instructions are available.
+*       By default bodies are integrated 4 (SSE2) or 8 (AVX) at a time from the packed bodies state arrays.
+*
 *   #define PHYSAC_DEBUG
 *       Traces log messages when creating and destroying physics bodies and detects errors in physics
 *       calculations and reference exceptions; it is useful for debug purposes
@@ -39,7 +47,11 @@
 *       Otherwise it will include stdlib.h and use the C standard library malloc()/free() function.
 *
 *
-*   NOTE 1: Physac requires multi-threading, when InitPhysics() a second thread is created to manage physics calculations.
+*   NOTE 1: Physac requires multi-threading, every world created with CreatePhysicsWorld() gets a thread to manage its physics
+*           calculations. The thread sleeps until the next fixed time step is due and blocks while every body is sleeping, it is
+*           woken up when a body is created, receives a force or gets woken up.
+*           Unless PHYSAC_NO_WORKERS is set, all worlds also share a small pool of worker threads that solves contact islands.
+*           Creating and destroying bodies waits for the thread to finish its current step, bodies storage may grow meanwhile.
 *   NOTE 2: Physac requires static C library linkage to avoid dependency on MinGW DLL (-static -lpthread)
 *
 *   Use the following code to compile:
@@ -82,6 +94,7 @@
 
 // #define PHYSAC_STATIC
 // #define  PHYSAC_NO_THREADS
+// #define  PHYSAC_NO_WORKERS
 // #define  PHYSAC_STANDALONE
 // #define  PHYSAC_DEBUG
 
@@ -98,18 +111,37 @@
 //----------------------------------------------------------------------------------
 // Defines and Macros
 //----------------------------------------------------------------------------------
-#define     PHYSAC_MAX_BODIES               64
-#define     PHYSAC_MAX_MANIFOLDS            4096
+#if !defined(PHYSAC_BODIES_CAPACITY)
+    #define PHYSAC_BODIES_CAPACITY          64          // Can be defined before including this file to size the bodies storage of a new world, it doubles when full
+#endif
+#if !defined(PHYSAC_MANIFOLDS_CAPACITY)
+    #define PHYSAC_MANIFOLDS_CAPACITY       256         // Can be defined before including this file to size the manifolds arena of a new world, it doubles when full
+#endif
+#if !defined(PHYSAC_MAX_WORKERS)
+    #define PHYSAC_MAX_WORKERS              8           // Can be defined before including this file to cap the island solver threads, stepping thread included
+#endif
 #define     PHYSAC_MAX_VERTICES             24
 #define     PHYSAC_CIRCLE_VERTICES          24
 
-#define     PHYSAC_COLLISION_ITERATIONS     100
+#define     PHYSAC_COLLISION_ITERATIONS     10          // Impulses are warm started from the last step, so few iterations keep piles stable
 #define     PHYSAC_PENETRATION_ALLOWANCE    0.05f
 #define     PHYSAC_PENETRATION_CORRECTION   0.4f
+#define     PHYSAC_ADAPTIVE_THRESHOLD       0.002f      // Default contact velocity change, in pixels per millisecond, under which adaptive iterations stop
+#define     PHYSAC_PARALLEL_MANIFOLDS       64          // Steps with fewer manifolds solve their islands on the stepping thread, waking workers would cost more
+
+#define     PHYSAC_SLEEP_LINEAR_VELOCITY    0.01f       // Linear velocity under which a body is considered resting, in pixels per millisecond
+#define     PHYSAC_SLEEP_ANGULAR_VELOCITY   0.0005f     // Angular velocity under which a body is considered resting, in radians per millisecond
+#define     PHYSAC_SLEEP_TIME               500.0f      // Time in milliseconds a whole island has to rest before it goes to sleep
 
 #define     PHYSAC_PI                       3.14159265358979323846
 #define     PHYSAC_DEG2RAD                  (PHYSAC_PI/180.0f)
 
+#define     PHYSAC_BODY_SLOT_BITS           20          // Body id bits holding its slot, the remaining high bits count how many times the slot was reused
+#define     PHYSAC_BODY_SLOT_MASK           ((1u << PHYSAC_BODY_SLOT_BITS) - 1)
+
+#define     PHYSAC_SNAPSHOT_INDEX_MASK      0x3         // Triple buffer slot index bits
+#define     PHYSAC_SNAPSHOT_FRESH           0x4         // Set when the shared triple buffer slot holds a snapshot the reader has not seen
+
 #define     PHYSAC_MALLOC(size)             malloc(size)
 #define     PHYSAC_FREE(ptr)                free(ptr)
 
@@ -136,6 +168,9 @@ typedef enum PhysicsShapeType { PHYSICS_CIRCLE, PHYSICS_POLYGON } PhysicsShapeTy
 // Previously defined to be used in PhysicsShape struct as circular dependencies
 typedef struct PhysicsBodyData *PhysicsBody;
 
+// Independent simulation owning its bodies, manifolds and settings, bodies of different worlds never collide
+typedef struct PhysicsWorldData *PhysicsWorld;
+
 // Mat2 type (used for polygon shape rotation matrix)
 typedef struct Mat2 {
     float m00;
@@ -150,6 +185,11 @@ typedef struct PolygonData {
     Vector2 normals[PHYSAC_MAX_VERTICES];       // Polygon vertex normals vectors
 } PolygonData;
 
+typedef struct PhysicsAABB {
+    Vector2 min;                                // Axis aligned bounding box minimum corner
+    Vector2 max;                                // Axis aligned bounding box maximum corner
+} PhysicsAABB;
+
 typedef struct PhysicsShape {
     PhysicsShapeType type;                      // Physics shape type (circle or polygon)
     PhysicsBody body;                           // Shape physics body reference
@@ -158,26 +198,27 @@ typedef struct PhysicsShape {
     PolygonData vertexData;                     // Polygon shape vertices position and normals data (just used for polygon shapes)
 } PhysicsShape;
 
+// NOTE: Position, velocity, force, orient, angular velocity, torque and inverse mass/inertia are stored
+// in packed per-field arrays, use GetPhysicsBodyPosition(), GetPhysicsBodyOrient() and friends to access them
 typedef struct PhysicsBodyData {
-    unsigned int id;                            // Reference unique identifier
+    unsigned int id;                            // Reference unique identifier within its world, body slot in the low PHYSAC_BODY_SLOT_BITS
+    unsigned int index;                         // Packed bodies state arrays index
+    unsigned int broadphaseIndex;               // Broadphase sorted bodies array index
+    PhysicsWorld world;                         // World the body was created in
     bool enabled;                               // Enabled dynamics state (collisions are calculated anyway)
-    Vector2 position;                           // Physics body shape pivot
-    Vector2 velocity;                           // Current linear velocity applied to position
-    Vector2 force;                              // Current linear force (reset to 0 every step)
-    float angularVelocity;                      // Current angular velocity applied to orient
-    float torque;                               // Current angular force (reset to 0 every step)
-    float orient;                               // Rotation in radians
     float inertia;                              // Moment of inertia
-    float inverseInertia;                       // Inverse value of inertia
     float mass;                                 // Physics body mass
-    float inverseMass;                          // Inverse value of mass
     float staticFriction;                       // Friction when the body has not movement (0 to 1)
     float dynamicFriction;                      // Friction when the body has movement (0 to 1)
     float restitution;                          // Restitution coefficient of the body (0 to 1)
     bool useGravity;                            // Apply gravity force to dynamics
     bool isGrounded;                            // Physics grounded on other body state
     bool freezeOrient;                          // Physics rotation constraint
+    bool isSleeping;                            // Physics body is resting and skipped by the solver until woken up
+    float sleepTime;                            // Time in milliseconds the body has been resting
+    unsigned int island;                        // Island the body was put to sleep with, the whole island wakes up together
     PhysicsShape shape;                         // Physics body shape information (type, radius, vertices, normals)
+    PhysicsAABB aabb;                           // World space bounding box, updated by the broadphase every step
 } PhysicsBodyData;
 
 typedef struct PhysicsManifoldData {
@@ -188,11 +229,49 @@ typedef struct PhysicsManifoldData {
     Vector2 normal;                             // Normal direction vector from 'a' to 'b'
     Vector2 contacts[2];                        // Points of contact during collision
     unsigned int contactsCount;                 // Current collision number of contacts
+    unsigned int features[2];                   // Shape features that generated each contact, used to match contacts between steps
+    float normalImpulses[2];                    // Accumulated impulse along the normal of each contact
+    float tangentImpulses[2];                   // Accumulated friction impulse along the tangent of each contact
+    float normalMasses[2];                      // Inverse of the effective mass along the normal of each contact
+    float tangentMasses[2];                     // Inverse of the effective mass along the tangent of each contact
+    float velocityBiases[2];                    // Separating velocity targeted by restitution at each contact
     float restitution;                          // Mixed restitution during collision
     float dynamicFriction;                      // Mixed dynamic friction during collision
     float staticFriction;                       // Mixed static friction during collision
 } PhysicsManifoldData, *PhysicsManifold;
 
+typedef struct PhysicsBodySnapshot {
+    unsigned int id;                            // Physics body reference unique identifier
+    Vector2 position;                           // Physics body shape pivot
+    float orient;                               // Rotation in radians
+    Vector2 previousPosition;                   // Physics body shape pivot before the last step
+    float previousOrient;                       // Rotation in radians before the last step
+    PhysicsAABB aabb;                           // World space bounding box
+} PhysicsBodySnapshot;
+
+// NOTE: Snapshots are published by the physics thread at the end of RunPhysicsStep() and never modified afterwards
+typedef struct PhysicsSnapshot {
+    unsigned int stepsCount;                    // Physics steps count when the snapshot was published
+    double time;                                // Physics clock time in milliseconds the current transforms belong to
+    double deltaTime;                           // Fixed time step in milliseconds between previous and current transforms
+    unsigned int bodiesCount;                   // Amount of bodies stored in the snapshot
+    unsigned int indicesCount;                  // Amount of body id slots stored in the snapshot
+    unsigned int capacity;                      // Allocated bodies and indices entries
+    PhysicsBodySnapshot *bodies;                // Bodies transforms, same order as the physics bodies pool
+    int *indices;                               // Bodies array index of every body id slot, -1 if the slot holds no body
+} PhysicsSnapshot;
+
+typedef struct PhysicsSolverSettings {
+    int iterations;                             // Collision impulses iterations per step, upper bound when adaptive
+    double timeStep;                            // Fixed time step in milliseconds, same as SetPhysicsTimeStep()
+    int maxSubsteps;                            // Most steps a single RunPhysicsStep() call runs, older time is dropped, 0 for no limit
+    float penetrationAllowance;                 // Penetration depth left uncorrected between bodies in contact
+    float penetrationCorrection;                // Fraction of the remaining penetration corrected every step
+    bool adaptiveIterations;                    // Stops iterating once impulses barely change contacts velocities
+    float adaptiveThreshold;                    // Largest contact velocity change, in pixels per millisecond, that still counts as converged
+    int workers;                                // Most threads solving contact islands of a step together, stepping thread included, 0 for the whole pool
+} PhysicsSolverSettings;
+
 #if defined(__cplusplus)
 extern "C" {                                    // Prevents name mangling of functions
 #endif
@@ -200,25 +279,47 @@ extern "C" {                                    // Prevents name mangling of fun
 //----------------------------------------------------------------------------------
 // Module Functions Declaration
 //----------------------------------------------------------------------------------
-PHYSACDEF void InitPhysics(void);                                                                           // Initializes physics values, pointers and creates physics loop thread
-PHYSACDEF void RunPhysicsStep(void);                                                                        // Run physics step, to be used if PHYSICS_NO_THREADS is set in your main loop
-PHYSACDEF void SetPhysicsTimeStep(double delta);                                                            // Sets physics fixed time step in milliseconds. 1.666666 by default
-PHYSACDEF bool IsPhysicsEnabled(void);                                                                      // Returns true if physics thread is currently enabled
-PHYSACDEF void SetPhysicsGravity(float x, float y);                                                         // Sets physics global gravity force
-PHYSACDEF PhysicsBody CreatePhysicsBodyCircle(Vector2 pos, float radius, float density);                    // Creates a new circle physics body with generic parameters
-PHYSACDEF PhysicsBody CreatePhysicsBodyRectangle(Vector2 pos, float width, float height, float density);    // Creates a new rectangle physics body with generic parameters
-PHYSACDEF PhysicsBody CreatePhysicsBodyPolygon(Vector2 pos, float radius, int sides, float density);        // Creates a new polygon physics body with generic parameters
+PHYSACDEF PhysicsWorld CreatePhysicsWorld(void);                                                            // Creates an empty physics world and, unless PHYSAC_NO_THREADS is set, its physics loop thread
+PHYSACDEF void RunPhysicsStep(PhysicsWorld world);                                                          // Run physics step, to be used if PHYSICS_NO_THREADS is set in your main loop
+PHYSACDEF void SetPhysicsTimeStep(PhysicsWorld world, double delta);                                        // Sets physics fixed time step in milliseconds. 1.666666 by default
+PHYSACDEF PhysicsSolverSettings GetPhysicsSolverSettings(PhysicsWorld world);                               // Returns current solver settings, including the fixed time step
+PHYSACDEF void SetPhysicsSolverSettings(PhysicsWorld world, PhysicsSolverSettings settings);                // Replaces solver settings, takes effect on next physics step
+PHYSACDEF bool IsPhysicsEnabled(PhysicsWorld world);                                                        // Returns true if physics thread is currently enabled
+PHYSACDEF void SetPhysicsGravity(PhysicsWorld world, float x, float y);                                     // Sets physics world gravity force
+PHYSACDEF PhysicsBody CreatePhysicsBodyCircle(PhysicsWorld world, Vector2 pos, float radius, float density); // Creates a new circle physics body with generic parameters
+PHYSACDEF PhysicsBody CreatePhysicsBodyRectangle(PhysicsWorld world, Vector2 pos, float width, float height, float density); // Creates a new rectangle physics body with generic parameters
+PHYSACDEF PhysicsBody CreatePhysicsBodyPolygon(PhysicsWorld world, Vector2 pos, float radius, int sides, float density); // Creates a new polygon physics body with generic parameters
 PHYSACDEF void PhysicsAddForce(PhysicsBody body, Vector2 force);                                            // Adds a force to a physics body
 PHYSACDEF void PhysicsAddTorque(PhysicsBody body, float amount);                                            // Adds an angular force to a physics body
 PHYSACDEF void PhysicsShatter(PhysicsBody body, Vector2 position, float force);                             // Shatters a polygon shape physics body to little physics bodies with explosion force
-PHYSACDEF int GetPhysicsBodiesCount(void);                                                                  // Returns the current amount of created physics bodies
-PHYSACDEF PhysicsBody GetPhysicsBody(int index);                                                            // Returns a physics body of the bodies pool at a specific index
-PHYSACDEF int GetPhysicsShapeType(int index);                                                               // Returns the physics body shape type (PHYSICS_CIRCLE or PHYSICS_POLYGON)
-PHYSACDEF int GetPhysicsShapeVerticesCount(int index);                                                      // Returns the amount of vertices of a physics body shape
+PHYSACDEF int GetPhysicsBodiesCount(PhysicsWorld world);                                                    // Returns the current amount of created physics bodies
+PHYSACDEF unsigned int GetPhysicsStepsCount(PhysicsWorld world);                                            // Returns the total amount of physics steps that simulated awake bodies
+PHYSACDEF unsigned int GetPhysicsIterationsCount(PhysicsWorld world);                                       // Returns the total amount of collision iterations run, divide by steps count for the average per step
+PHYSACDEF unsigned int GetPhysicsCulledPairsCount(PhysicsWorld world);                                      // Returns the amount of body pairs discarded by the broadphase in the last step
+PHYSACDEF unsigned int GetPhysicsDroppedManifoldsCount(PhysicsWorld world);                                 // Returns the total amount of contacts lost because the manifolds arena could not grow
+PHYSACDEF PhysicsBody GetPhysicsBody(PhysicsWorld world, int index);                                        // Returns a physics body of the bodies pool at a specific index
+PHYSACDEF int GetPhysicsShapeType(PhysicsWorld world, int index);                                           // Returns the physics body shape type (PHYSICS_CIRCLE or PHYSICS_POLYGON)
+PHYSACDEF int GetPhysicsShapeVerticesCount(PhysicsWorld world, int index);                                  // Returns the amount of vertices of a physics body shape
 PHYSACDEF Vector2 GetPhysicsShapeVertex(PhysicsBody body, int vertex);                                      // Returns transformed position of a body shape (body position + vertex transformed position)
 PHYSACDEF void SetPhysicsBodyRotation(PhysicsBody body, float radians);                                     // Sets physics body shape transform based on radians parameter
+PHYSACDEF Vector2 GetPhysicsBodyPosition(PhysicsBody body);                                                 // Returns physics body shape pivot position
+PHYSACDEF void SetPhysicsBodyPosition(PhysicsBody body, Vector2 position);                                  // Sets physics body shape pivot position
+PHYSACDEF Vector2 GetPhysicsBodyVelocity(PhysicsBody body);                                                 // Returns physics body linear velocity
+PHYSACDEF void SetPhysicsBodyVelocity(PhysicsBody body, Vector2 velocity);                                  // Sets physics body linear velocity
+PHYSACDEF float GetPhysicsBodyOrient(PhysicsBody body);                                                     // Returns physics body rotation in radians
+PHYSACDEF float GetPhysicsBodyAngularVelocity(PhysicsBody body);                                            // Returns physics body angular velocity
+PHYSACDEF void SetPhysicsBodyAngularVelocity(PhysicsBody body, float angularVelocity);                      // Sets physics body angular velocity
+PHYSACDEF bool IsPhysicsBodySleeping(PhysicsBody body);                                                     // Returns true if physics body is sleeping
+PHYSACDEF void WakeUpPhysicsBody(PhysicsBody body);                                                         // Wakes up a sleeping physics body and the rest of its island
+PHYSACDEF int GetPhysicsAwakeBodiesCount(PhysicsWorld world);                                               // Returns the amount of dynamic bodies that are not sleeping
+PHYSACDEF const PhysicsSnapshot *GetPhysicsSnapshot(PhysicsWorld world);                                    // Returns the latest published snapshot of bodies transforms, safe to call from a single render thread
+PHYSACDEF const PhysicsBodySnapshot *GetPhysicsSnapshotBody(const PhysicsSnapshot *snapshot, unsigned int id); // Returns a body transform from a snapshot by body id, NULL if it was not in the snapshot
+PHYSACDEF float GetPhysicsSnapshotAlpha(const PhysicsSnapshot *snapshot, double time);                     // Returns the interpolation factor between previous and current transforms at a physics clock time
+PHYSACDEF Vector2 GetPhysicsSnapshotBodyPosition(const PhysicsBodySnapshot *body, float alpha);            // Returns a body position blended between previous and current step
+PHYSACDEF float GetPhysicsSnapshotBodyOrient(const PhysicsBodySnapshot *body, float alpha);                // Returns a body rotation blended between previous and current step
+PHYSACDEF double GetPhysicsTime(void);                                                                      // Returns current physics clock time in milliseconds, shared by every world
 PHYSACDEF void DestroyPhysicsBody(PhysicsBody body);                                                        // Unitializes and destroy a physics body
-PHYSACDEF void ClosePhysics(void);                                                                          // Unitializes physics pointers and closes physics loop thread
+PHYSACDEF void DestroyPhysicsWorld(PhysicsWorld world);                                                     // Closes physics loop thread and destroys a world with all of its bodies
 
 #if defined(__cplusplus)
 }
@@ -234,8 +335,16 @@ PHYSACDEF void ClosePhysics(void);
 
 #if defined(PHYSAC_IMPLEMENTATION)
 
-#if !defined(PHYSAC_NO_THREADS)
-    #include <pthread.h>            // Required for: pthread_t, pthread_create()
+#if !defined(PHYSAC_NO_THREADS) || !defined(PHYSAC_NO_WORKERS)
+    #include <pthread.h>            // Required for: pthread_t, pthread_create(), pthread_cond_wait()
+    #include <stdatomic.h>          // Required for: atomic_uint, atomic_exchange_explicit()
+#endif
+
+#if !defined(PHYSAC_NO_WORKERS)
+    #include <unistd.h>             // Required for: sysconf()
+    #if defined(__linux__)
+        #include <stdio.h>          // Required for: fopen(), fscanf()
+    #endif
 #endif
 
 #if defined(PHYSAC_DEBUG)
@@ -243,13 +352,24 @@ PHYSACDEF void ClosePhysics(void);
 #endif
 
 #include <stdlib.h>                 // Required for: malloc(), free(), srand(), rand()
-#include <math.h>                   // Required for: cosf(), sinf(), fabs(), sqrtf()
+#include <string.h>                 // Required for: memset()
+#include <math.h>                   // Required for: cosf(), sinf(), fabs(), sqrtf(), fmod()
 #include <stdint.h>                 // Required for: uint64_t
 
 #if !defined(PHYSAC_STANDALONE)
     #include "raymath.h"            // Required for: Vector2Add(), Vector2Subtract()
 #endif
 
+#if !defined(PHYSAC_NO_SIMD)
+    #if defined(__AVX__)
+        #include <immintrin.h>      // Required for: __m256, _mm256_loadu_ps(), _mm256_mul_ps()...
+        #define PHYSAC_SIMD_AVX
+    #elif defined(__SSE2__)
+        #include <emmintrin.h>      // Required for: __m128, _mm_loadu_ps(), _mm_mul_ps()...
+        #define PHYSAC_SIMD_SSE2
+    #endif
+#endif
+
 // Time management functionality
 #include <time.h>                   // Required for: time(), clock_gettime()
 #if defined(_WIN32)
@@ -263,11 +383,12 @@ PHYSACDEF void ClosePhysics(void);
     }
     #endif
 #elif defined(__linux__)
-    #if _POSIX_C_SOURCE < 199309L
+    #if _POSIX_C_SOURCE < 200112L
         #undef _POSIX_C_SOURCE
-        #define _POSIX_C_SOURCE 199309L // Required for CLOCK_MONOTONIC if compiled with c99 without gnu ext.
+        #define _POSIX_C_SOURCE 200112L // Required for CLOCK_MONOTONIC and clock_nanosleep() if compiled with c99 without gnu ext.
     #endif
     #include <sys/time.h>           // Required for: timespec
+    #include <errno.h>              // Required for: EINTR
 #elif defined(__APPLE__)            // macOS also defines __MACH__
     #include <mach/mach_time.h>     // Required for: mach_absolute_time()
 
@@ -285,52 +406,224 @@ PHYSACDEF void ClosePhysics(void);
 #define     PHYSAC_K                    1.0f/3.0f
 #define     PHYSAC_VECTOR_ZERO          (Vector2){ 0.0f, 0.0f }
 
+// Packed floats operations used by integration kernels, PHYSAC_SIMD_WIDTH bodies are processed at a time
+#if defined(PHYSAC_SIMD_AVX)
+    #define PHYSAC_SIMD_WIDTH           8
+    typedef __m256 PhysacFloats;
+    #define SimdLoad(ptr)               _mm256_loadu_ps(ptr)
+    #define SimdStore(ptr, v)           _mm256_storeu_ps(ptr, v)
+    #define SimdSet(value)              _mm256_set1_ps(value)
+    #define SimdAdd(a, b)               _mm256_add_ps(a, b)
+    #define SimdMul(a, b)               _mm256_mul_ps(a, b)
+#elif defined(PHYSAC_SIMD_SSE2)
+    #define PHYSAC_SIMD_WIDTH           4
+    typedef __m128 PhysacFloats;
+    #define SimdLoad(ptr)               _mm_loadu_ps(ptr)
+    #define SimdStore(ptr, v)           _mm_storeu_ps(ptr, v)
+    #define SimdSet(value)              _mm_set1_ps(value)
+    #define SimdAdd(a, b)               _mm_add_ps(a, b)
+    #define SimdMul(a, b)               _mm_mul_ps(a, b)
+#endif
+
 //----------------------------------------------------------------------------------
-// Global Variables Definition
+// Types and Structures Definition (internal)
 //----------------------------------------------------------------------------------
+// Packed hot state of physics bodies, indexed by PhysicsBodyData.index, every array holds bodiesCapacity entries
+typedef struct PhysicsBodiesState {
+    float *positionX;                           // Physics body shape pivot x
+    float *positionY;                           // Physics body shape pivot y
+    float *velocityX;                           // Current linear velocity x applied to position
+    float *velocityY;                           // Current linear velocity y applied to position
+    float *forceX;                              // Current linear force x (reset to 0 every step)
+    float *forceY;                              // Current linear force y (reset to 0 every step)
+    float *orient;                              // Rotation in radians
+    float *previousPositionX;                   // Physics body shape pivot x before the last step
+    float *previousPositionY;                   // Physics body shape pivot y before the last step
+    float *previousOrient;                      // Rotation in radians before the last step
+    float *angularVelocity;                     // Current angular velocity applied to orient
+    float *torque;                              // Current angular force (reset to 0 every step)
+    float *inverseMass;                         // Inverse value of mass
+    float *inverseInertia;                      // Inverse value of inertia
+    float *enabledMask;                         // 1.0f if body dynamics are enabled, 0.0f otherwise
+    float *dynamicMask;                         // 1.0f if body is enabled and has finite mass, 0.0f otherwise
+    float *gravityMask;                         // 1.0f if body uses gravity, 0.0f otherwise
+    float *rotationMask;                        // 0.0f if body rotation is frozen, 1.0f otherwise
+} PhysicsBodiesState;
+
+// Accumulated impulses of a manifold at the end of a step, looked up by body pair on the next one
+typedef struct PhysicsContactCacheSlot {
+    uint64_t key;                               // Ids of both bodies, lower id in the high bits
+    unsigned int stamp;                         // Contact cache generation the slot was written in, other generations are empty
+    unsigned int contactsCount;                 // Amount of cached contacts
+    unsigned int features[2];                   // Shape features of the cached contacts
+    float normalImpulses[2];                    // Accumulated normal impulses of the cached contacts
+    float tangentImpulses[2];                   // Accumulated tangent impulses of the cached contacts
+} PhysicsContactCacheSlot;
+
+// Body id slot, free slots are linked together and reused by new bodies with the next generation
+typedef struct PhysicsBodySlot {
+    unsigned int generation;                    // Times the slot was released, high bits of the id of its current body
+    int next;                                   // Next free slot while this one is free, -1 for the last one
+} PhysicsBodySlot;
+
+#if !defined(PHYSAC_NO_WORKERS)
+// Island tasks of a worker for the current batch, the owner pops from the bottom and idle workers steal from the top
+typedef struct PhysicsWorkerQueue {
+    atomic_int top;                             // Next task stolen by other workers
+    atomic_int bottom;                          // One past the next task popped by the owner
+} PhysicsWorkerQueue;
+
+// Worker threads shared by every world, the thread running a step takes part in its batch as worker 0
+typedef struct PhysicsWorkerPool {
+    pthread_t threads[PHYSAC_MAX_WORKERS];      // Worker threads, entry 0 is never started
+    int workersCount;                           // Workers including the stepping thread
+    int worldsCount;                            // Worlds using the pool, the last one destroyed stops the workers
+    pthread_mutex_t mutex;                      // Guards batch generation, running state and worlds count
+    pthread_cond_t condition;                   // Wakes workers up for a new batch or to exit
+    pthread_mutex_t batchMutex;                 // Held by the step running a batch, concurrent steps solve their islands alone meanwhile
+    unsigned int generation;                    // Incremented for every batch, workers run each batch once
+    bool running;                               // Workers exit once cleared
+    PhysicsWorld world;                         // World whose islands the current batch solves
+    int batchWorkers;                           // Workers taking part in the current batch
+    int busyWorkers;                            // Worker threads that did not finish the current batch yet, guarded by mutex
+    pthread_cond_t doneCondition;               // Wakes the stepping thread up once the last worker finished the batch
+    PhysicsWorkerQueue queues[PHYSAC_MAX_WORKERS]; // Island tasks of every worker in the current batch
+} PhysicsWorkerPool;
+#endif
+
+// Whole state of a physics world, every world steps on its own and shares nothing but the clock with the others
+typedef struct PhysicsWorldData {
 #if !defined(PHYSAC_NO_THREADS)
-static pthread_t physicsThreadId;                           // Physics thread id
+    pthread_t physicsThreadId;                              // Physics thread id
+    pthread_mutex_t physicsThreadMutex;                     // Physics thread wake up mutex
+    pthread_mutex_t physicsStepMutex;                       // Held by physics thread while it steps, bodies are only created and destroyed under it
+    pthread_cond_t physicsThreadCondition;                  // Physics thread wake up condition
+    bool physicsThreadWakeUp;                               // Physics thread wake up requested since it last waited
+    atomic_uint snapshotShared;                             // Triple buffer slot exchanged between physics and render threads, plus fresh flag
+#else
+    unsigned int snapshotShared;                            // Triple buffer slot exchanged between RunPhysicsStep() and the reader, plus fresh flag
 #endif
+    volatile bool physicsThreadEnabled;                     // Physics thread enabled state
+    double startTime;                                       // Start time in milliseconds
+    double deltaTime;                                       // Delta time used for physics steps, in milliseconds
+    double currentTime;                                     // Current time in milliseconds
+
+    double accumulator;                                     // Physics time step delta time accumulator
+    unsigned int stepsCount;                                // Total physics steps processed
+    unsigned int iterationsCount;                           // Total collision impulses iterations run by physics steps
+    PhysicsSolverSettings solverSettings;                   // Solver settings, the time step is kept in deltaTime
+    bool physicsIdle;                                       // Every body was sleeping at the end of last RunPhysicsStep() call
+    Vector2 gravityForce;                                   // Physics world gravity force
+    PhysicsBody *bodies;                                    // Physics bodies pointers array, same order as packed state
+    PhysicsBodiesState bodiesState;                         // Physics bodies packed hot state arrays
+    unsigned int physicsBodiesCount;                        // Physics world current bodies counter
+    unsigned int bodiesCapacity;                            // Entries allocated in every per body array, doubled when a new body does not fit
+    PhysicsBodySlot *bodySlots;                             // Body id slots, indexed by the low bits of body ids
+    unsigned int bodySlotsCount;                            // Slots handed out at least once, never above bodies capacity
+    int freeBodySlot;                                       // First slot of the free slots list, -1 if every handed out slot is in use
+    PhysicsManifoldData *manifolds;                         // Physics manifolds arena, reset at the start of every step
+    unsigned int physicsManifoldsCount;                     // Physics world current manifolds counter
+    unsigned int manifoldsCapacity;                         // Entries allocated in manifolds arena and islandManifolds, doubled when a new manifold does not fit
+    unsigned int droppedManifoldsCount;                     // Contacts lost because the manifolds arena could not grow, bodies went through each other
+    PhysicsBody *broadphaseBodies;                          // Physics bodies pointers sorted by bounding box minimum x
+    unsigned int broadphaseBodiesCount;                     // Broadphase sorted bodies counter
+    unsigned int broadphaseCulledPairs;                     // Body pairs discarded by the broadphase in the last step
+    int *islandParents;                                     // Contact islands union-find parents, indexed like bodies array
+    float *islandSleepTimes;                                // Shortest resting time of each contact island, indexed by island root
+    unsigned int islandsCount;                              // Total islands put to sleep, used as unique island identifier
+    int *islandIds;                                         // Solver island of every island root, -1 until one of its manifolds is found
+    int *islandManifolds;                                   // Manifolds indices grouped by solver island, in arena order within an island
+    int *islandManifoldsStart;                              // First islandManifolds entry of every solver island, plus the end of the last one
+    int *islandIterations;                                  // Collision iterations run by every solver island in the current step
+    int *islandTasks;                                       // Solver islands dealt to the workers, each worker owns a contiguous slice
+    int *islandOrder;                                       // Solver islands sorted by size while dealing them to the workers
+    int solverIslandsCount;                                 // Contact islands of the current step, they share no dynamic body and are solved independently
+    PhysicsSnapshot snapshots[3];                           // Bodies transforms triple buffer
+    unsigned int snapshotWriteIndex;                        // Triple buffer slot owned by the physics thread
+    unsigned int snapshotReadIndex;                         // Triple buffer slot owned by the render thread
+    bool snapshotDirty;                                     // Bodies were created or destroyed since the last published snapshot
+    PhysicsContactCacheSlot *contactCache;                  // Manifolds impulses of the last step, open addressing hash table
+    unsigned int contactCacheSlots;                         // Contact cache size, a power of two at least twice the manifolds capacity
+    unsigned int contactCacheStamp;                         // Current contact cache generation, bumped to empty the whole table
+} PhysicsWorldData;
+
+//----------------------------------------------------------------------------------
+// Global Variables Definition
+//----------------------------------------------------------------------------------
 static unsigned int usedMemory = 0;                         // Total allocated dynamic memory
-static volatile bool physicsThreadEnabled = false;          // Physics thread enabled state
-static double baseTime = 0.0;                               // Offset time for MONOTONIC clock
-static double startTime = 0.0;                              // Start time in milliseconds
-static double deltaTime = 1.0/60.0/10.0 * 1000;             // Delta time used for physics steps, in milliseconds
-static double currentTime = 0.0;                            // Current time in milliseconds
+static double baseTime = 0.0;                               // Offset time for MONOTONIC clock, shared by every world
 static uint64_t frequency = 0;                              // Hi-res clock frequency
-
-static double accumulator = 0.0;                            // Physics time step delta time accumulator
-static unsigned int stepsCount = 0;                         // Total physics steps processed
-static Vector2 gravityForce = { 0.0f, 9.81f };              // Physics world gravity force
-static PhysicsBody bodies[PHYSAC_MAX_BODIES];               // Physics bodies pointers array
-static unsigned int physicsBodiesCount = 0;                 // Physics world current bodies counter
-static PhysicsManifold contacts[PHYSAC_MAX_MANIFOLDS];      // Physics bodies pointers array
-static unsigned int physicsManifoldsCount = 0;              // Physics world current manifolds counter
+#if !defined(PHYSAC_NO_WORKERS)
+static PhysicsWorkerPool physicsWorkers = {                 // Island solver workers, started with the first world
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .condition = PTHREAD_COND_INITIALIZER,
+    .doneCondition = PTHREAD_COND_INITIALIZER,
+    .batchMutex = PTHREAD_MUTEX_INITIALIZER
+};
+#endif
 
 //----------------------------------------------------------------------------------
 // Module Internal Functions Declaration
 //----------------------------------------------------------------------------------
-static int FindAvailableBodyIndex();                                                                        // Finds a valid index for a new physics body initialization
+static bool ReservePhysicsBodyId(PhysicsWorld world, unsigned int *id);                                     // Takes a free body id, growing bodies storage first if it is full
+static void ReleasePhysicsBodyId(PhysicsWorld world, unsigned int id);                                      // Puts the slot of a destroyed body id back on the free list with the next generation
+static bool GrowPhysicsBodies(PhysicsWorld world);                                                          // Doubles the capacity of every per body array of a world
+static bool GrowPhysicsManifolds(PhysicsWorld world);                                                       // Doubles the capacity of the manifolds arena of a world, its contact cache follows
+static bool GrowPhysicsArray(void **array, unsigned int count, unsigned int capacity, size_t size);         // Moves the first count elements of an array into a new allocation, keeps it untouched on failure
+static void FreePhysicsBodies(PhysicsWorld world);                                                          // Frees every per body array, manifolds arena and snapshot of a world
 static PolygonData CreateRandomPolygon(float radius, int sides);                                            // Creates a random polygon shape with max vertex distance from polygon pivot
 static PolygonData CreateRectanglePolygon(Vector2 pos, Vector2 size);                                       // Creates a rectangle polygon shape based on a min and max positions
+static void SignalPhysicsThread(PhysicsWorld world);                                                        // Wakes up physics thread if it is blocked waiting for awake bodies
+static void LockPhysicsWorld(PhysicsWorld world);                                                           // Waits for physics thread to finish its current step and keeps it from starting another
+static void UnlockPhysicsWorld(PhysicsWorld world);                                                         // Lets physics thread step again
+#if !defined(PHYSAC_NO_THREADS)
 static void *PhysicsLoop(void *arg);                                                                        // Physics loop thread function
-static void PhysicsStep(void);                                                                              // Physics steps calculations (dynamics, collisions and position corrections)
-static int FindAvailableManifoldIndex();                                                                    // Finds a valid index for a new manifold initialization
-static PhysicsManifold CreatePhysicsManifold(PhysicsBody a, PhysicsBody b);                                 // Creates a new physics manifold to solve collision
-static void DestroyPhysicsManifold(PhysicsManifold manifold);                                               // Unitializes and destroys a physics manifold
+static void WaitPhysicsWakeUp(PhysicsWorld world);                                                          // Blocks physics thread until a body is created or woken up
+static void WaitPhysicsStepDeadline(PhysicsWorld world);                                                    // Sleeps physics thread until next fixed time step is due
+#endif
+static void PhysicsStep(PhysicsWorld world);                                                                // Physics steps calculations (dynamics, collisions and position corrections)
+static PhysicsAABB GetPhysicsBodyAABB(PhysicsBody body);                                                    // Computes the world space bounding box of a physics body shape
+static void UpdatePhysicsBroadphase(PhysicsWorld world);                                                    // Updates bodies bounding boxes and keeps broadphase array sorted along x axis
+static void GeneratePhysicsContacts(PhysicsBody a, PhysicsBody b);                                          // Runs narrowphase between two bodies and stores the manifold if they collide
+static PhysicsManifold CreatePhysicsManifold(PhysicsBody a, PhysicsBody b);                                 // Initializes the next free manifold of the manifolds arena to solve collision
+static uint64_t GetPhysicsContactCacheKey(PhysicsManifold manifold);                                        // Returns the contact cache key of a manifold bodies pair
+static void LoadPhysicsContactCache(PhysicsManifold manifold);                                              // Carries over accumulated impulses of contacts that persisted since last step
+static void StorePhysicsContactCache(PhysicsWorld world);                                                   // Replaces the contact cache with accumulated impulses of current manifolds
 static void SolvePhysicsManifold(PhysicsManifold manifold);                                                 // Solves a created physics manifold between two physics bodies
 static void SolveCircleToCircle(PhysicsManifold manifold);                                                  // Solves collision between two circle shape physics bodies
 static void SolveCircleToPolygon(PhysicsManifold manifold);                                                 // Solves collision between a circle to a polygon shape physics bodies
 static void SolvePolygonToCircle(PhysicsManifold manifold);                                                 // Solves collision between a polygon to a circle shape physics bodies
 static void SolveDifferentShapes(PhysicsManifold manifold, PhysicsBody bodyA, PhysicsBody bodyB);           // Solve collision between two different types of shapes
 static void SolvePolygonToPolygon(PhysicsManifold manifold);                                                // Solves collision between two polygons shape physics bodies
-static void IntegratePhysicsForces(PhysicsBody body);                                                       // Integrates physics forces into velocity
+static void InitPhysicsBodyState(PhysicsBody body, Vector2 pos);                                            // Appends the packed state of a new physics body
+static void SetPhysicsBodyMassData(PhysicsBody body, float mass, float inertia);                            // Sets physics body mass and inertia and their inverse values
+static void UpdatePhysicsBodiesMasks(PhysicsWorld world);                                                   // Copies bodies flags into packed state masks used by integration kernels
+static bool IsPhysicsBodyDynamic(PhysicsBody body);                                                         // Returns true if physics body is enabled and has finite mass
+static int FindPhysicsIsland(PhysicsWorld world, int index);                                                // Returns contact island root of a body index
+static void BuildPhysicsIslands(PhysicsWorld world);                                                        // Joins touching dynamic bodies into contact islands and groups manifolds by island
+static void SolvePhysicsIslands(PhysicsWorld world);                                                        // Solves collisions of every contact island, on the worker pool when the step has enough manifolds
+static void SolvePhysicsIsland(PhysicsWorld world, int island);                                             // Initializes and iterates collision impulses of a single contact island
+#if !defined(PHYSAC_NO_WORKERS)
+static int GetPhysicsCoresCount(void);                                                                      // Returns the amount of physical cores, logical processors when topology is unknown
+static void StartPhysicsWorkers(void);                                                                      // Starts the worker pool with the first world
+static void StopPhysicsWorkers(void);                                                                       // Stops the worker pool with the last world
+static void *PhysicsWorkerLoop(void *arg);                                                                  // Worker thread function, runs every batch it is woken up for
+static void RunPhysicsWorkerTasks(int worker);                                                              // Solves islands of a worker queue, then steals from the others until every queue is empty
+static int PopPhysicsWorkerTask(PhysicsWorkerQueue *queue);                                                 // Takes the last task of a worker own queue, -1 if empty
+static int StealPhysicsWorkerTask(PhysicsWorkerQueue *queue);                                               // Takes the first task of another worker queue, -1 if empty and -2 if another worker won the race
+static void RunPhysicsWorkersBatch(PhysicsWorld world, int workers);                                        // Deals islands to workers queues and solves them together with the pool
+#endif
+static void UpdatePhysicsSleeping(PhysicsWorld world);                                                      // Puts resting contact islands to sleep
+static void PublishPhysicsSnapshot(PhysicsWorld world);                                                     // Copies bodies transforms into the triple buffer and hands it to the reader
+static void ApplyPhysicsImpulse(PhysicsBody body, Vector2 impulse, Vector2 contactVector);                  // Applies an impulse at a contact vector relative to body center of mass
+static Vector2 GetContactRelativeVelocity(PhysicsBody bodyA, PhysicsBody bodyB, Vector2 radiusA, Vector2 radiusB); // Returns relative velocity of body B with respect to body A at a contact point
+static void IntegratePhysicsForces(PhysicsWorld world);                                                     // Integrates physics forces into velocity
 static void InitializePhysicsManifolds(PhysicsManifold manifold);                                           // Initializes physics manifolds to solve collisions
-static void IntegratePhysicsImpulses(PhysicsManifold manifold);                                             // Integrates physics collisions impulses to solve collisions
-static void IntegratePhysicsVelocity(PhysicsBody body);                                                     // Integrates physics velocity into position and forces
+static float IntegratePhysicsImpulses(PhysicsManifold manifold);                                            // Integrates physics collisions impulses to solve collisions, returns the largest contact velocity change
+static void IntegratePhysicsVelocity(PhysicsWorld world);                                                   // Integrates physics velocity into position and forces
 static void CorrectPhysicsPositions(PhysicsManifold manifold);                                              // Corrects physics bodies positions based on manifolds collision information
 static float FindAxisLeastPenetration(int *faceIndex, PhysicsShape shapeA, PhysicsShape shapeB);            // Finds polygon shapes axis least penetration
-static void FindIncidentFace(Vector2 *v0, Vector2 *v1, PhysicsShape ref, PhysicsShape inc, int index);      // Finds two polygon shapes incident face
+static int FindIncidentFace(Vector2 *v0, Vector2 *v1, PhysicsShape ref, PhysicsShape inc, int index);       // Finds two polygon shapes incident face and returns its index
 static int Clip(Vector2 normal, float clip, Vector2 *faceA, Vector2 *faceB);                                // Calculates clipping based on a normal and two faces
 static bool BiasGreaterThan(float valueA, float valueB);                                                    // Check if values are between bias range
 static Vector2 TriangleBarycenter(Vector2 v1, Vector2 v2, Vector2 v3);                                      // Returns the barycenter of a triangle given by 3 points
@@ -359,107 +652,174 @@ static inline Vector2 Mat2MultiplyVector2(Mat2 matrix, Vector2 vector);
 //----------------------------------------------------------------------------------
 // Module Functions Definition
 //----------------------------------------------------------------------------------
-// Initializes physics values, pointers and creates physics loop thread
-PHYSACDEF void InitPhysics(void)
+// Creates an empty physics world and, unless PHYSAC_NO_THREADS is set, its physics loop thread
+PHYSACDEF PhysicsWorld CreatePhysicsWorld(void)
 {
+    PhysicsWorld world = (PhysicsWorld)PHYSAC_MALLOC(sizeof(PhysicsWorldData));
+
+    if (world == NULL)
+    {
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] physics world creation failed because it could not be allocated\n");
+        #endif
+        return NULL;
+    }
+
+    memset(world, 0, sizeof(PhysicsWorldData));
+    world->freeBodySlot = -1;
+
+    if (!GrowPhysicsBodies(world) || !GrowPhysicsManifolds(world))
+    {
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] physics world creation failed because its bodies or manifolds storage could not be allocated\n");
+        #endif
+        FreePhysicsBodies(world);
+        PHYSAC_FREE(world);
+        return NULL;
+    }
+
+    // Initialize high resolution timer once, every world schedules its steps on the same clock
+    if (frequency == 0)
+        InitTimer();
+
+    world->startTime = GetCurrentTime();
+    world->deltaTime = 1.0/60.0/10.0 * 1000;
+    world->solverSettings = (PhysicsSolverSettings){
+        .iterations = PHYSAC_COLLISION_ITERATIONS,
+        .maxSubsteps = 0,
+        .penetrationAllowance = PHYSAC_PENETRATION_ALLOWANCE,
+        .penetrationCorrection = PHYSAC_PENETRATION_CORRECTION,
+        .adaptiveIterations = false,
+        .adaptiveThreshold = PHYSAC_ADAPTIVE_THRESHOLD,
+        .workers = 0
+    };
+    world->physicsIdle = true;
+    world->gravityForce = (Vector2){ 0.0f, 9.81f };
+    world->snapshotWriteIndex = 0;
+    world->snapshotReadIndex = 2;
+    world->contactCacheStamp = 1;
+
+    #if !defined(PHYSAC_NO_WORKERS)
+        StartPhysicsWorkers();
+    #endif
+
     #if !defined(PHYSAC_NO_THREADS)
+        pthread_mutex_init(&world->physicsThreadMutex, NULL);
+        pthread_mutex_init(&world->physicsStepMutex, NULL);
+        pthread_cond_init(&world->physicsThreadCondition, NULL);
+        atomic_init(&world->snapshotShared, 1);
+
+        // Enabled before the thread starts, so destroying the world right away cannot miss it
+        world->physicsThreadEnabled = true;
+
         // NOTE: if defined, user will need to create a thread for PhysicsThread function manually
         // Create physics thread using POSIXS thread libraries
-        pthread_create(&physicsThreadId, NULL, &PhysicsLoop, NULL);
+        pthread_create(&world->physicsThreadId, NULL, &PhysicsLoop, world);
+    #else
+        world->snapshotShared = 1;
     #endif
 
-    // Initialize high resolution timer
-    InitTimer();
-
     #if defined(PHYSAC_DEBUG)
-        printf("[PHYSAC] physics module initialized successfully\n");
+        printf("[PHYSAC] physics world created successfully\n");
     #endif
 
-    accumulator = 0.0;
+    return world;
 }
 
 // Returns true if physics thread is currently enabled
-PHYSACDEF bool IsPhysicsEnabled(void)
+PHYSACDEF bool IsPhysicsEnabled(PhysicsWorld world)
 {
-    return physicsThreadEnabled;
+    return world->physicsThreadEnabled;
 }
 
-// Sets physics global gravity force
-PHYSACDEF void SetPhysicsGravity(float x, float y)
+// Sets physics world gravity force
+PHYSACDEF void SetPhysicsGravity(PhysicsWorld world, float x, float y)
 {
-    gravityForce.x = x;
-    gravityForce.y = y;
+    world->gravityForce.x = x;
+    world->gravityForce.y = y;
 }
 
 // Creates a new circle physics body with generic parameters
-PHYSACDEF PhysicsBody CreatePhysicsBodyCircle(Vector2 pos, float radius, float density)
+PHYSACDEF PhysicsBody CreatePhysicsBodyCircle(PhysicsWorld world, Vector2 pos, float radius, float density)
 {
     PhysicsBody newBody = (PhysicsBody)PHYSAC_MALLOC(sizeof(PhysicsBodyData));
-    usedMemory += sizeof(PhysicsBodyData);
 
-    int newId = FindAvailableBodyIndex();
-    if (newId != -1)
+    LockPhysicsWorld(world);
+
+    if ((newBody != NULL) && ReservePhysicsBodyId(world, &newBody->id))
     {
+        usedMemory += sizeof(PhysicsBodyData);
+
         // Initialize new body with generic values
-        newBody->id = newId;
+        newBody->world = world;
         newBody->enabled = true;
-        newBody->position = pos;
-        newBody->velocity = PHYSAC_VECTOR_ZERO;
-        newBody->force = PHYSAC_VECTOR_ZERO;
-        newBody->angularVelocity = 0.0f;
-        newBody->torque = 0.0f;
-        newBody->orient = 0.0f;
+        InitPhysicsBodyState(newBody, pos);
         newBody->shape.type = PHYSICS_CIRCLE;
         newBody->shape.body = newBody;
         newBody->shape.radius = radius;
         newBody->shape.transform = Mat2Radians(0.0f);
         newBody->shape.vertexData = (PolygonData) { 0 };
 
-        newBody->mass = PHYSAC_PI*radius*radius*density;
-        newBody->inverseMass = ((newBody->mass != 0.0f) ? 1.0f/newBody->mass : 0.0f);
-        newBody->inertia = newBody->mass*radius*radius;
-        newBody->inverseInertia = ((newBody->inertia != 0.0f) ? 1.0f/newBody->inertia : 0.0f);
+        float mass = PHYSAC_PI*radius*radius*density;
+        SetPhysicsBodyMassData(newBody, mass, mass*radius*radius);
         newBody->staticFriction = 0.4f;
         newBody->dynamicFriction = 0.2f;
         newBody->restitution = 0.0f;
         newBody->useGravity = true;
         newBody->isGrounded = false;
         newBody->freezeOrient = false;
+        newBody->isSleeping = false;
+        newBody->sleepTime = 0.0f;
+        newBody->island = 0;
 
         // Add new body to bodies pointers array and update bodies count
-        bodies[physicsBodiesCount] = newBody;
-        physicsBodiesCount++;
+        world->bodies[world->physicsBodiesCount] = newBody;
+        world->physicsBodiesCount++;
+
+        // Add new body to broadphase array, it gets sorted in the next physics step
+        newBody->aabb = GetPhysicsBodyAABB(newBody);
+        newBody->broadphaseIndex = world->broadphaseBodiesCount;
+        world->broadphaseBodies[world->broadphaseBodiesCount] = newBody;
+        world->broadphaseBodiesCount++;
+
+        SignalPhysicsThread(world);
 
         #if defined(PHYSAC_DEBUG)
-            printf("[PHYSAC] created polygon physics body id %i\n", newBody->id);
+            printf("[PHYSAC] created polygon physics body id %u\n", newBody->id);
         #endif
     }
-    #if defined(PHYSAC_DEBUG)
-        else
-            printf("[PHYSAC] new physics body creation failed because there is any available id to use\n");
-    #endif
+    else
+    {
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] new physics body creation failed because bodies storage could not grow\n");
+        #endif
+
+        if (newBody != NULL)
+            PHYSAC_FREE(newBody);
+
+        newBody = NULL;
+    }
+
+    UnlockPhysicsWorld(world);
 
     return newBody;
 }
 
 // Creates a new rectangle physics body with generic parameters
-PHYSACDEF PhysicsBody CreatePhysicsBodyRectangle(Vector2 pos, float width, float height, float density)
+PHYSACDEF PhysicsBody CreatePhysicsBodyRectangle(PhysicsWorld world, Vector2 pos, float width, float height, float density)
 {
     PhysicsBody newBody = (PhysicsBody)PHYSAC_MALLOC(sizeof(PhysicsBodyData));
-    usedMemory += sizeof(PhysicsBodyData);
 
-    int newId = FindAvailableBodyIndex();
-    if (newId != -1)
+    LockPhysicsWorld(world);
+
+    if ((newBody != NULL) && ReservePhysicsBodyId(world, &newBody->id))
     {
+        usedMemory += sizeof(PhysicsBodyData);
+
         // Initialize new body with generic values
-        newBody->id = newId;
+        newBody->world = world;
         newBody->enabled = true;
-        newBody->position = pos;
-        newBody->velocity = (Vector2){ 0.0f };
-        newBody->force = (Vector2){ 0.0f };
-        newBody->angularVelocity = 0.0f;
-        newBody->torque = 0.0f;
-        newBody->orient = 0.0f;
+        InitPhysicsBodyState(newBody, pos);
         newBody->shape.type = PHYSICS_POLYGON;
         newBody->shape.body = newBody;
         newBody->shape.radius = 0.0f;
@@ -503,51 +863,65 @@ PHYSACDEF PhysicsBody CreatePhysicsBodyRectangle(Vector2 pos, float width, float
             newBody->shape.vertexData.positions[i].y -= center.y;
         }
 
-        newBody->mass = density*area;
-        newBody->inverseMass = ((newBody->mass != 0.0f) ? 1.0f/newBody->mass : 0.0f);
-        newBody->inertia = density*inertia;
-        newBody->inverseInertia = ((newBody->inertia != 0.0f) ? 1.0f/newBody->inertia : 0.0f);
+        SetPhysicsBodyMassData(newBody, density*area, density*inertia);
         newBody->staticFriction = 0.4f;
         newBody->dynamicFriction = 0.2f;
         newBody->restitution = 0.0f;
         newBody->useGravity = true;
         newBody->isGrounded = false;
         newBody->freezeOrient = false;
+        newBody->isSleeping = false;
+        newBody->sleepTime = 0.0f;
+        newBody->island = 0;
 
         // Add new body to bodies pointers array and update bodies count
-        bodies[physicsBodiesCount] = newBody;
-        physicsBodiesCount++;
+        world->bodies[world->physicsBodiesCount] = newBody;
+        world->physicsBodiesCount++;
+
+        // Add new body to broadphase array, it gets sorted in the next physics step
+        newBody->aabb = GetPhysicsBodyAABB(newBody);
+        newBody->broadphaseIndex = world->broadphaseBodiesCount;
+        world->broadphaseBodies[world->broadphaseBodiesCount] = newBody;
+        world->broadphaseBodiesCount++;
+
+        SignalPhysicsThread(world);
 
         #if defined(PHYSAC_DEBUG)
-            printf("[PHYSAC] created polygon physics body id %i\n", newBody->id);
+            printf("[PHYSAC] created polygon physics body id %u\n", newBody->id);
         #endif
     }
-    #if defined(PHYSAC_DEBUG)
-        else
-            printf("[PHYSAC] new physics body creation failed because there is any available id to use\n");
-    #endif
+    else
+    {
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] new physics body creation failed because bodies storage could not grow\n");
+        #endif
+
+        if (newBody != NULL)
+            PHYSAC_FREE(newBody);
+
+        newBody = NULL;
+    }
+
+    UnlockPhysicsWorld(world);
 
     return newBody;
 }
 
 // Creates a new polygon physics body with generic parameters
-PHYSACDEF PhysicsBody CreatePhysicsBodyPolygon(Vector2 pos, float radius, int sides, float density)
+PHYSACDEF PhysicsBody CreatePhysicsBodyPolygon(PhysicsWorld world, Vector2 pos, float radius, int sides, float density)
 {
     PhysicsBody newBody = (PhysicsBody)PHYSAC_MALLOC(sizeof(PhysicsBodyData));
-    usedMemory += sizeof(PhysicsBodyData);
 
-    int newId = FindAvailableBodyIndex();
-    if (newId != -1)
+    LockPhysicsWorld(world);
+
+    if ((newBody != NULL) && ReservePhysicsBodyId(world, &newBody->id))
     {
+        usedMemory += sizeof(PhysicsBodyData);
+
         // Initialize new body with generic values
-        newBody->id = newId;
+        newBody->world = world;
         newBody->enabled = true;
-        newBody->position = pos;
-        newBody->velocity = PHYSAC_VECTOR_ZERO;
-        newBody->force = PHYSAC_VECTOR_ZERO;
-        newBody->angularVelocity = 0.0f;
-        newBody->torque = 0.0f;
-        newBody->orient = 0.0f;
+        InitPhysicsBodyState(newBody, pos);
         newBody->shape.type = PHYSICS_POLYGON;
         newBody->shape.body = newBody;
         newBody->shape.transform = Mat2Radians(0.0f);
@@ -590,29 +964,46 @@ PHYSACDEF PhysicsBody CreatePhysicsBodyPolygon(Vector2 pos, float radius, int si
             newBody->shape.vertexData.positions[i].y -= center.y;
         }
 
-        newBody->mass = density*area;
-        newBody->inverseMass = ((newBody->mass != 0.0f) ? 1.0f/newBody->mass : 0.0f);
-        newBody->inertia = density*inertia;
-        newBody->inverseInertia = ((newBody->inertia != 0.0f) ? 1.0f/newBody->inertia : 0.0f);
+        SetPhysicsBodyMassData(newBody, density*area, density*inertia);
         newBody->staticFriction = 0.4f;
         newBody->dynamicFriction = 0.2f;
         newBody->restitution = 0.0f;
         newBody->useGravity = true;
         newBody->isGrounded = false;
         newBody->freezeOrient = false;
+        newBody->isSleeping = false;
+        newBody->sleepTime = 0.0f;
+        newBody->island = 0;
 
         // Add new body to bodies pointers array and update bodies count
-        bodies[physicsBodiesCount] = newBody;
-        physicsBodiesCount++;
+        world->bodies[world->physicsBodiesCount] = newBody;
+        world->physicsBodiesCount++;
+
+        // Add new body to broadphase array, it gets sorted in the next physics step
+        newBody->aabb = GetPhysicsBodyAABB(newBody);
+        newBody->broadphaseIndex = world->broadphaseBodiesCount;
+        world->broadphaseBodies[world->broadphaseBodiesCount] = newBody;
+        world->broadphaseBodiesCount++;
+
+        SignalPhysicsThread(world);
 
         #if defined(PHYSAC_DEBUG)
-            printf("[PHYSAC] created polygon physics body id %i\n", newBody->id);
+            printf("[PHYSAC] created polygon physics body id %u\n", newBody->id);
         #endif
     }
-    #if defined(PHYSAC_DEBUG)
-        else
-            printf("[PHYSAC] new physics body creation failed because there is any available id to use\n");
-    #endif
+    else
+    {
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] new physics body creation failed because bodies storage could not grow\n");
+        #endif
+
+        if (newBody != NULL)
+            PHYSAC_FREE(newBody);
+
+        newBody = NULL;
+    }
+
+    UnlockPhysicsWorld(world);
 
     return newBody;
 }
@@ -621,14 +1012,21 @@ PHYSACDEF PhysicsBody CreatePhysicsBodyPolygon(Vector2 pos, float radius, int si
 PHYSACDEF void PhysicsAddForce(PhysicsBody body, Vector2 force)
 {
     if (body != NULL)
-        body->force = Vector2Add(body->force, force);
+    {
+        body->world->bodiesState.forceX[body->index] += force.x;
+        body->world->bodiesState.forceY[body->index] += force.y;
+        WakeUpPhysicsBody(body);
+    }
 }
 
 // Adds an angular force to a physics body
 PHYSACDEF void PhysicsAddTorque(PhysicsBody body, float amount)
 {
     if (body != NULL)
-        body->torque += amount;
+    {
+        body->world->bodiesState.torque[body->index] += amount;
+        WakeUpPhysicsBody(body);
+    }
 }
 
 // Shatters a polygon shape physics body to little physics bodies with explosion force
@@ -639,14 +1037,15 @@ PHYSACDEF void PhysicsShatter(PhysicsBody body, Vector2 position, float force)
         if (body->shape.type == PHYSICS_POLYGON)
         {
             PolygonData vertexData = body->shape.vertexData;
+            Vector2 bodyPos = GetPhysicsBodyPosition(body);
             bool collision = false;
 
             for (int i = 0; i < vertexData.vertexCount; i++)
             {
-                Vector2 positionA = body->position;
-                Vector2 positionB = Mat2MultiplyVector2(body->shape.transform, Vector2Add(body->position, vertexData.positions[i]));
+                Vector2 positionA = bodyPos;
+                Vector2 positionB = Mat2MultiplyVector2(body->shape.transform, Vector2Add(bodyPos, vertexData.positions[i]));
                 int nextIndex = (((i + 1) < vertexData.vertexCount) ? (i + 1) : 0);
-                Vector2 positionC = Mat2MultiplyVector2(body->shape.transform, Vector2Add(body->position, vertexData.positions[nextIndex]));
+                Vector2 positionC = Mat2MultiplyVector2(body->shape.transform, Vector2Add(bodyPos, vertexData.positions[nextIndex]));
 
                 // Check collision between each triangle
                 float alpha = ((positionB.y - positionC.y)*(position.x - positionC.x) + (positionC.x - positionB.x)*(position.y - positionC.y))/
@@ -667,10 +1066,13 @@ PHYSACDEF void PhysicsShatter(PhysicsBody body, Vector2 position, float force)
             if (collision)
             {
                 int count = vertexData.vertexCount;
-                Vector2 bodyPos = body->position;
                 Vector2 *vertices = (Vector2*)PHYSAC_MALLOC(sizeof(Vector2) * count);
                 Mat2 trans = body->shape.transform;
-                
+                PhysicsWorld world = body->world;
+
+                if (vertices == NULL)
+                    return;
+
                 for (int i = 0; i < count; i++)
                     vertices[i] = vertexData.positions[i];
 
@@ -684,7 +1086,11 @@ PHYSACDEF void PhysicsShatter(PhysicsBody body, Vector2 position, float force)
                     center = Vector2Add(bodyPos, center);
                     Vector2 offset = Vector2Subtract(center, bodyPos);
 
-                    PhysicsBody newBody = CreatePhysicsBodyPolygon(center, 10, 3, 10);     // Create polygon physics body with relevant values
+                    PhysicsBody newBody = CreatePhysicsBodyPolygon(world, center, 10, 3, 10);  // Create polygon physics body with relevant values, in the shattered body world
+
+                    // Bodies storage could not grow, the remaining pieces are lost with the shattered body
+                    if (newBody == NULL)
+                        continue;
 
                     PolygonData newData = { 0 };
                     newData.vertexCount = 3;
@@ -744,17 +1150,14 @@ PHYSACDEF void PhysicsShatter(PhysicsBody body, Vector2 position, float force)
                     center.x *= 1.0f/area;
                     center.y *= 1.0f/area;
 
-                    newBody->mass = area;
-                    newBody->inverseMass = ((newBody->mass != 0.0f) ? 1.0f/newBody->mass : 0.0f);
-                    newBody->inertia = inertia;
-                    newBody->inverseInertia = ((newBody->inertia != 0.0f) ? 1.0f/newBody->inertia : 0.0f);
+                    SetPhysicsBodyMassData(newBody, area, inertia);
 
                     // Calculate explosion force direction
-                    Vector2 pointA = newBody->position;
+                    Vector2 pointA = GetPhysicsBodyPosition(newBody);
                     Vector2 pointB = Vector2Subtract(newData.positions[1], newData.positions[0]);
                     pointB.x /= 2.0f;
                     pointB.y /= 2.0f;
-                    Vector2 forceDirection = Vector2Subtract(Vector2Add(pointA, Vector2Add(newData.positions[0], pointB)), newBody->position);
+                    Vector2 forceDirection = Vector2Subtract(Vector2Add(pointA, Vector2Add(newData.positions[0], pointB)), pointA);
                     MathNormalize(&forceDirection);
                     forceDirection.x *= force;
                     forceDirection.y *= force;
@@ -774,17 +1177,41 @@ PHYSACDEF void PhysicsShatter(PhysicsBody body, Vector2 position, float force)
 }
 
 // Returns the current amount of created physics bodies
-PHYSACDEF int GetPhysicsBodiesCount(void)
+PHYSACDEF int GetPhysicsBodiesCount(PhysicsWorld world)
+{
+    return world->physicsBodiesCount;
+}
+
+// Returns the total amount of physics steps that simulated awake bodies
+PHYSACDEF unsigned int GetPhysicsStepsCount(PhysicsWorld world)
+{
+    return world->stepsCount;
+}
+
+// Returns the total amount of collision iterations run, divide by steps count for the average per step
+PHYSACDEF unsigned int GetPhysicsIterationsCount(PhysicsWorld world)
+{
+    return world->iterationsCount;
+}
+
+// Returns the amount of body pairs discarded by the broadphase in the last step
+PHYSACDEF unsigned int GetPhysicsCulledPairsCount(PhysicsWorld world)
+{
+    return world->broadphaseCulledPairs;
+}
+
+// Returns the total amount of contacts lost because the manifolds arena could not grow
+PHYSACDEF unsigned int GetPhysicsDroppedManifoldsCount(PhysicsWorld world)
 {
-    return physicsBodiesCount;
+    return world->droppedManifoldsCount;
 }
 
 // Returns a physics body of the bodies pool at a specific index
-PHYSACDEF PhysicsBody GetPhysicsBody(int index)
+PHYSACDEF PhysicsBody GetPhysicsBody(PhysicsWorld world, int index)
 {
-    if (index < physicsBodiesCount)
+    if (index < world->physicsBodiesCount)
     {
-        if (bodies[index] == NULL)
+        if (world->bodies[index] == NULL)
         {
             #if defined(PHYSAC_DEBUG)
                 printf("[PHYSAC] error when trying to get a null reference physics body");
@@ -796,18 +1223,18 @@ PHYSACDEF PhysicsBody GetPhysicsBody(int index)
             printf("[PHYSAC] physics body index is out of bounds");
     #endif
 
-    return bodies[index];
+    return world->bodies[index];
 }
 
 // Returns the physics body shape type (PHYSICS_CIRCLE or PHYSICS_POLYGON)
-PHYSACDEF int GetPhysicsShapeType(int index)
+PHYSACDEF int GetPhysicsShapeType(PhysicsWorld world, int index)
 {
     int result = -1;
 
-    if (index < physicsBodiesCount)
+    if (index < world->physicsBodiesCount)
     {
-        if (bodies[index] != NULL) 
-            result = bodies[index]->shape.type;
+        if (world->bodies[index] != NULL) 
+            result = world->bodies[index]->shape.type;
 
         #if defined(PHYSAC_DEBUG)
             else
@@ -823,18 +1250,18 @@ PHYSACDEF int GetPhysicsShapeType(int index)
 }
 
 // Returns the amount of vertices of a physics body shape
-PHYSACDEF int GetPhysicsShapeVerticesCount(int index)
+PHYSACDEF int GetPhysicsShapeVerticesCount(PhysicsWorld world, int index)
 {
     int result = 0;
 
-    if (index < physicsBodiesCount)
+    if (index < world->physicsBodiesCount)
     {
-        if (bodies[index] != NULL)
+        if (world->bodies[index] != NULL)
         {
-            switch (bodies[index]->shape.type)
+            switch (world->bodies[index]->shape.type)
             {
                 case PHYSICS_CIRCLE: result = PHYSAC_CIRCLE_VERTICES; break;
-                case PHYSICS_POLYGON: result = bodies[index]->shape.vertexData.vertexCount; break;
+                case PHYSICS_POLYGON: result = world->bodies[index]->shape.vertexData.vertexCount; break;
                 default: break;
             }
         }
@@ -862,13 +1289,14 @@ PHYSACDEF Vector2 GetPhysicsShapeVertex(PhysicsBody body, int vertex)
         {
             case PHYSICS_CIRCLE:
             {
-                position.x = body->position.x + cosf(360.0f/PHYSAC_CIRCLE_VERTICES*vertex*PHYSAC_DEG2RAD)*body->shape.radius;
-                position.y = body->position.y + sinf(360.0f/PHYSAC_CIRCLE_VERTICES*vertex*PHYSAC_DEG2RAD)*body->shape.radius;
+                position = GetPhysicsBodyPosition(body);
+                position.x += cosf(360.0f/PHYSAC_CIRCLE_VERTICES*vertex*PHYSAC_DEG2RAD)*body->shape.radius;
+                position.y += sinf(360.0f/PHYSAC_CIRCLE_VERTICES*vertex*PHYSAC_DEG2RAD)*body->shape.radius;
             } break;
             case PHYSICS_POLYGON:
             {
                 PolygonData vertexData = body->shape.vertexData;
-                position = Vector2Add(body->position, Mat2MultiplyVector2(body->shape.transform, vertexData.positions[vertex]));
+                position = Vector2Add(GetPhysicsBodyPosition(body), Mat2MultiplyVector2(body->shape.transform, vertexData.positions[vertex]));
             } break;
             default: break;
         }
@@ -886,448 +1314,1640 @@ PHYSACDEF void SetPhysicsBodyRotation(PhysicsBody body, float radians)
 {
     if (body != NULL)
     {
-        body->orient = radians;
+        // Teleport, renderers must not blend from the old rotation
+        body->world->bodiesState.orient[body->index] = radians;
+        body->world->bodiesState.previousOrient[body->index] = radians;
 
         if (body->shape.type == PHYSICS_POLYGON)
             body->shape.transform = Mat2Radians(radians);
+
+        WakeUpPhysicsBody(body);
     }
 }
 
-// Unitializes and destroys a physics body
-PHYSACDEF void DestroyPhysicsBody(PhysicsBody body)
+// Returns physics body shape pivot position
+PHYSACDEF Vector2 GetPhysicsBodyPosition(PhysicsBody body)
 {
+    Vector2 position = { 0.0f, 0.0f };
+
     if (body != NULL)
     {
-        int id = body->id;
-        int index = -1;
+        PhysicsBodiesState *state = &body->world->bodiesState;
+        position = (Vector2){ state->positionX[body->index], state->positionY[body->index] };
+    }
 
-        for (int i = 0; i < physicsBodiesCount; i++)
-        {
-            if (bodies[i]->id == id)
-            {
-                index = i;
-                break;
-            }
-        }
+    return position;
+}
 
-        if (index == -1)
-        {
-            #if defined(PHYSAC_DEBUG)
-                printf("[PHYSAC] Not possible to find body id %i in pointers array\n", id);
-            #endif
-            return;
-        }
+// Sets physics body shape pivot position
+PHYSACDEF void SetPhysicsBodyPosition(PhysicsBody body, Vector2 position)
+{
+    if (body != NULL)
+    {
+        // Teleport, renderers must not blend from the old position
+        PhysicsBodiesState *state = &body->world->bodiesState;
+        state->positionX[body->index] = position.x;
+        state->positionY[body->index] = position.y;
+        state->previousPositionX[body->index] = position.x;
+        state->previousPositionY[body->index] = position.y;
+        WakeUpPhysicsBody(body);
+    }
+}
 
-        // Free body allocated memory
-        PHYSAC_FREE(body);
-        usedMemory -= sizeof(PhysicsBodyData);
-        bodies[index] = NULL;
+// Returns physics body linear velocity
+PHYSACDEF Vector2 GetPhysicsBodyVelocity(PhysicsBody body)
+{
+    Vector2 velocity = { 0.0f, 0.0f };
 
-        // Reorder physics bodies pointers array and its catched index
-        for (int i = index; i < physicsBodiesCount; i++)
-        {
-            if ((i + 1) < physicsBodiesCount)
-                bodies[i] = bodies[i + 1];
-        }
+    if (body != NULL)
+    {
+        PhysicsBodiesState *state = &body->world->bodiesState;
+        velocity = (Vector2){ state->velocityX[body->index], state->velocityY[body->index] };
+    }
 
-        // Update physics bodies count
-        physicsBodiesCount--;
+    return velocity;
+}
 
-        #if defined(PHYSAC_DEBUG)
-            printf("[PHYSAC] destroyed physics body id %i\n", id);
-        #endif
+// Sets physics body linear velocity
+PHYSACDEF void SetPhysicsBodyVelocity(PhysicsBody body, Vector2 velocity)
+{
+    if (body != NULL)
+    {
+        body->world->bodiesState.velocityX[body->index] = velocity.x;
+        body->world->bodiesState.velocityY[body->index] = velocity.y;
+        WakeUpPhysicsBody(body);
     }
-    #if defined(PHYSAC_DEBUG)
-        else
-            printf("[PHYSAC] error trying to destroy a null referenced body\n");
-    #endif
 }
 
-// Unitializes physics pointers and exits physics loop thread
-PHYSACDEF void ClosePhysics(void)
+// Returns physics body rotation in radians
+PHYSACDEF float GetPhysicsBodyOrient(PhysicsBody body)
 {
-    // Exit physics loop thread
-    physicsThreadEnabled = false;
-
-    #if !defined(PHYSAC_NO_THREADS)
-        pthread_join(physicsThreadId, NULL);
-    #endif
+    return ((body != NULL) ? body->world->bodiesState.orient[body->index] : 0.0f);
+}
 
-    // Unitialize physics manifolds dynamic memory allocations
-    for (int i = physicsManifoldsCount - 1; i >= 0; i--)
-        DestroyPhysicsManifold(contacts[i]);
+// Returns physics body angular velocity
+PHYSACDEF float GetPhysicsBodyAngularVelocity(PhysicsBody body)
+{
+    return ((body != NULL) ? body->world->bodiesState.angularVelocity[body->index] : 0.0f);
+}
 
-    // Unitialize physics bodies dynamic memory allocations
-    for (int i = physicsBodiesCount - 1; i >= 0; i--)
-        DestroyPhysicsBody(bodies[i]);
+// Sets physics body angular velocity
+PHYSACDEF void SetPhysicsBodyAngularVelocity(PhysicsBody body, float angularVelocity)
+{
+    if (body != NULL)
+    {
+        body->world->bodiesState.angularVelocity[body->index] = angularVelocity;
+        WakeUpPhysicsBody(body);
+    }
+}
 
-    #if defined(PHYSAC_DEBUG)
-        if (physicsBodiesCount > 0 || usedMemory != 0)
-            printf("[PHYSAC] physics module closed with %i still allocated bodies [MEMORY: %i bytes]\n", physicsBodiesCount, usedMemory);
-        else if (physicsManifoldsCount > 0 || usedMemory != 0)
-            printf("[PHYSAC] physics module closed with %i still allocated manifolds [MEMORY: %i bytes]\n", physicsManifoldsCount, usedMemory);
-        else
-            printf("[PHYSAC] physics module closed successfully\n");
-    #endif
+// Returns true if physics body is sleeping
+PHYSACDEF bool IsPhysicsBodySleeping(PhysicsBody body)
+{
+    return ((body != NULL) ? body->isSleeping : false);
 }
 
-//----------------------------------------------------------------------------------
-// Module Internal Functions Definition
-//----------------------------------------------------------------------------------
-// Finds a valid index for a new physics body initialization
-static int FindAvailableBodyIndex()
+// Wakes up a sleeping physics body and the rest of its island
+PHYSACDEF void WakeUpPhysicsBody(PhysicsBody body)
 {
-    int index = -1;
-    for (int i = 0; i < PHYSAC_MAX_BODIES; i++)
+    if (body != NULL)
     {
-        int currentId = i;
+        PhysicsWorld world = body->world;
 
-        // Check if current id already exist in other physics body
-        for (int k = 0; k < physicsBodiesCount; k++)
+        // Restart resting time so recently touched bodies do not fall asleep right away
+        body->sleepTime = 0.0f;
+        SignalPhysicsThread(world);
+
+        if (body->isSleeping)
         {
-            if (bodies[k]->id == currentId)
+            unsigned int island = body->island;
+
+            for (int i = 0; i < world->physicsBodiesCount; i++)
             {
-                currentId++;
-                break;
+                if (world->bodies[i]->isSleeping && (world->bodies[i]->island == island))
+                {
+                    world->bodies[i]->isSleeping = false;
+                    world->bodies[i]->sleepTime = 0.0f;
+                }
             }
         }
-
-        // If it is not used, use it as new physics body id
-        if (currentId == i)
-        {
-            index = i;
-            break;
-        }
     }
-
-    return index;
 }
 
-// Creates a random polygon shape with max vertex distance from polygon pivot
-static PolygonData CreateRandomPolygon(float radius, int sides)
+// Returns the amount of dynamic bodies that are not sleeping
+PHYSACDEF int GetPhysicsAwakeBodiesCount(PhysicsWorld world)
 {
-    PolygonData data = { 0 };
-    data.vertexCount = sides;
+    int count = 0;
 
-    // Calculate polygon vertices positions
-    for (int i = 0; i < data.vertexCount; i++)
+    for (int i = 0; i < world->physicsBodiesCount; i++)
     {
-        data.positions[i].x = cosf(360.0f/sides*i*PHYSAC_DEG2RAD)*radius;
-        data.positions[i].y = sinf(360.0f/sides*i*PHYSAC_DEG2RAD)*radius;
+        if (IsPhysicsBodyDynamic(world->bodies[i]) && !world->bodies[i]->isSleeping)
+            count++;
     }
 
-    // Calculate polygon faces normals
-    for (int i = 0; i < data.vertexCount; i++)
-    {
-        int nextIndex = (((i + 1) < sides) ? (i + 1) : 0);
-        Vector2 face = Vector2Subtract(data.positions[nextIndex], data.positions[i]);
+    return count;
+}
 
-        data.normals[i] = (Vector2){ face.y, -face.x };
-        MathNormalize(&data.normals[i]);
-    }
+// Returns the latest published snapshot of bodies transforms
+// NOTE: Only one thread may read snapshots, the returned pointer stays valid until its next call
+PHYSACDEF const PhysicsSnapshot *GetPhysicsSnapshot(PhysicsWorld world)
+{
+    #if !defined(PHYSAC_NO_THREADS)
+        if (atomic_load_explicit(&world->snapshotShared, memory_order_relaxed) & PHYSAC_SNAPSHOT_FRESH)
+            world->snapshotReadIndex = atomic_exchange_explicit(&world->snapshotShared, world->snapshotReadIndex, memory_order_acq_rel) & PHYSAC_SNAPSHOT_INDEX_MASK;
+    #else
+        if (world->snapshotShared & PHYSAC_SNAPSHOT_FRESH)
+        {
+            unsigned int shared = world->snapshotShared;
+            world->snapshotShared = world->snapshotReadIndex;
+            world->snapshotReadIndex = shared & PHYSAC_SNAPSHOT_INDEX_MASK;
+        }
+    #endif
 
-    return data;
+    return &world->snapshots[world->snapshotReadIndex];
 }
 
-// Creates a rectangle polygon shape based on a min and max positions
-static PolygonData CreateRectanglePolygon(Vector2 pos, Vector2 size)
+// Returns a body transform from a snapshot by body id
+PHYSACDEF const PhysicsBodySnapshot *GetPhysicsSnapshotBody(const PhysicsSnapshot *snapshot, unsigned int id)
 {
-    PolygonData data = { 0 };
-    data.vertexCount = 4;
-
-    // Calculate polygon vertices positions
-    data.positions[0] = (Vector2){ pos.x + size.x/2, pos.y - size.y/2 };
-    data.positions[1] = (Vector2){ pos.x + size.x/2, pos.y + size.y/2 };
-    data.positions[2] = (Vector2){ pos.x - size.x/2, pos.y + size.y/2 };
-    data.positions[3] = (Vector2){ pos.x - size.x/2, pos.y - size.y/2 };
+    if ((snapshot == NULL) || ((id & PHYSAC_BODY_SLOT_MASK) >= snapshot->indicesCount))
+        return NULL;
 
-    // Calculate polygon faces normals
-    for (int i = 0; i < data.vertexCount; i++)
-    {
-        int nextIndex = (((i + 1) < data.vertexCount) ? (i + 1) : 0);
-        Vector2 face = Vector2Subtract(data.positions[nextIndex], data.positions[i]);
+    // NOTE: Slots never published yet are zeroed, indices count check rejects them
+    int index = snapshot->indices[id & PHYSAC_BODY_SLOT_MASK];
 
-        data.normals[i] = (Vector2){ face.y, -face.x };
-        MathNormalize(&data.normals[i]);
-    }
+    // A destroyed body slot may hold a newer body, generation bits of the id tell them apart
+    if ((index < 0) || (index >= (int)snapshot->bodiesCount) || (snapshot->bodies[index].id != id))
+        return NULL;
 
-    return data;
+    return &snapshot->bodies[index];
 }
 
-// Physics loop thread function
-static void *PhysicsLoop(void *arg)
+// Returns the interpolation factor between previous and current transforms at a physics clock time
+// NOTE: Blending renders one step behind simulation, 0.0f shows previous transforms and 1.0f current ones
+PHYSACDEF float GetPhysicsSnapshotAlpha(const PhysicsSnapshot *snapshot, double time)
 {
-    #if defined(PHYSAC_DEBUG)
-        printf("[PHYSAC] physics thread created successfully\n");
-    #endif
+    if ((snapshot == NULL) || (snapshot->deltaTime <= 0.0))
+        return 1.0f;
 
-    // Initialize physics loop thread values
-    physicsThreadEnabled = true;
+    float alpha = (float)((time - snapshot->time)/snapshot->deltaTime);
 
-    // Physics update loop
-    while (physicsThreadEnabled)
-    {
-        RunPhysicsStep();
-    }
+    if (alpha < 0.0f)
+        alpha = 0.0f;
+    else if (alpha > 1.0f)
+        alpha = 1.0f;
 
-    return NULL;
+    return alpha;
 }
 
-// Physics steps calculations (dynamics, collisions and position corrections)
-static void PhysicsStep(void)
+// Returns a body position blended between previous and current step
+PHYSACDEF Vector2 GetPhysicsSnapshotBodyPosition(const PhysicsBodySnapshot *body, float alpha)
 {
-    // Update current steps count
-    stepsCount++;
+    Vector2 position = { 0.0f, 0.0f };
 
-    // Clear previous generated collisions information
-    for (int i = physicsManifoldsCount - 1; i >= 0; i--)
+    if (body != NULL)
     {
-        PhysicsManifold manifold = contacts[i];
-        
-        if (manifold != NULL)
-            DestroyPhysicsManifold(manifold);
+        position.x = body->previousPosition.x + (body->position.x - body->previousPosition.x)*alpha;
+        position.y = body->previousPosition.y + (body->position.y - body->previousPosition.y)*alpha;
     }
 
-    // Reset physics bodies grounded state
-    for (int i = 0; i < physicsBodiesCount; i++)
-    {
-        PhysicsBody body = bodies[i];
-        body->isGrounded = false;
+    return position;
+}
+
+// Returns a body rotation blended between previous and current step
+PHYSACDEF float GetPhysicsSnapshotBodyOrient(const PhysicsBodySnapshot *body, float alpha)
+{
+    float orient = 0.0f;
+
+    if (body != NULL)
+        orient = body->previousOrient + (body->orient - body->previousOrient)*alpha;
+
+    return orient;
+}
+
+// Returns current physics clock time in milliseconds
+PHYSACDEF double GetPhysicsTime(void)
+{
+    return GetCurrentTime();
+}
+
+// Unitializes and destroys a physics body
+PHYSACDEF void DestroyPhysicsBody(PhysicsBody body)
+{
+    if (body != NULL)
+    {
+        PhysicsWorld world = body->world;
+        int index = body->index;
+
+        LockPhysicsWorld(world);
+
+        if ((index >= world->physicsBodiesCount) || (world->bodies[index] != body))
+        {
+            #if defined(PHYSAC_DEBUG)
+                printf("[PHYSAC] Not possible to find body id %u in pointers array\n", body->id);
+            #endif
+            UnlockPhysicsWorld(world);
+            return;
+        }
+
+        // Bodies resting on the destroyed one have to fall again
+        WakeUpPhysicsBody(body);
+
+        // Its manifolds are dropped too, destroying a body it touched before the next step must not reach it through them
+        for (int i = 0; i < world->physicsManifoldsCount; i++)
+        {
+            if ((world->manifolds[i].bodyA != body) && (world->manifolds[i].bodyB != body))
+                continue;
+
+            WakeUpPhysicsBody((world->manifolds[i].bodyA == body) ? world->manifolds[i].bodyB : world->manifolds[i].bodyA);
+
+            world->physicsManifoldsCount--;
+            world->manifolds[i] = world->manifolds[world->physicsManifoldsCount];
+            i--;
+        }
+
+        // Remove body from broadphase array, the last body fills its place and next step insertion sort moves it back
+        world->broadphaseBodiesCount--;
+        world->broadphaseBodies[body->broadphaseIndex] = world->broadphaseBodies[world->broadphaseBodiesCount];
+        world->broadphaseBodies[body->broadphaseIndex]->broadphaseIndex = body->broadphaseIndex;
+
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] destroyed physics body id %u\n", body->id);
+        #endif
+
+        ReleasePhysicsBodyId(world, body->id);
+
+        // Free body allocated memory
+        PHYSAC_FREE(body);
+        usedMemory -= sizeof(PhysicsBodyData);
+
+        // Move last body into the freed slot so pointers array and packed state stay dense
+        int last = world->physicsBodiesCount - 1;
+
+        if (index != last)
+        {
+            world->bodies[index] = world->bodies[last];
+            world->bodies[index]->index = index;
+
+            world->bodiesState.positionX[index] = world->bodiesState.positionX[last];
+            world->bodiesState.positionY[index] = world->bodiesState.positionY[last];
+            world->bodiesState.velocityX[index] = world->bodiesState.velocityX[last];
+            world->bodiesState.velocityY[index] = world->bodiesState.velocityY[last];
+            world->bodiesState.forceX[index] = world->bodiesState.forceX[last];
+            world->bodiesState.forceY[index] = world->bodiesState.forceY[last];
+            world->bodiesState.orient[index] = world->bodiesState.orient[last];
+            world->bodiesState.previousPositionX[index] = world->bodiesState.previousPositionX[last];
+            world->bodiesState.previousPositionY[index] = world->bodiesState.previousPositionY[last];
+            world->bodiesState.previousOrient[index] = world->bodiesState.previousOrient[last];
+            world->bodiesState.angularVelocity[index] = world->bodiesState.angularVelocity[last];
+            world->bodiesState.torque[index] = world->bodiesState.torque[last];
+            world->bodiesState.inverseMass[index] = world->bodiesState.inverseMass[last];
+            world->bodiesState.inverseInertia[index] = world->bodiesState.inverseInertia[last];
+        }
+
+        world->bodies[last] = NULL;
+
+        // Update physics bodies count
+        world->physicsBodiesCount--;
+        world->snapshotDirty = true;
+
+        UnlockPhysicsWorld(world);
     }
+    #if defined(PHYSAC_DEBUG)
+        else
+            printf("[PHYSAC] error trying to destroy a null referenced body\n");
+    #endif
+}
+
+// Closes physics loop thread and destroys a world with all of its bodies
+PHYSACDEF void DestroyPhysicsWorld(PhysicsWorld world)
+{
+    if (world == NULL)
+        return;
+
+    // Exit physics loop thread
+    world->physicsThreadEnabled = false;
+    SignalPhysicsThread(world);
+
+    #if !defined(PHYSAC_NO_THREADS)
+        pthread_join(world->physicsThreadId, NULL);
+    #endif
+
+    // Reset physics manifolds arena
+    world->physicsManifoldsCount = 0;
+
+    // Unitialize physics bodies dynamic memory allocations
+    for (int i = world->physicsBodiesCount - 1; i >= 0; i--)
+        DestroyPhysicsBody(world->bodies[i]);
+
+    #if defined(PHYSAC_DEBUG)
+        if (world->physicsBodiesCount > 0)
+            printf("[PHYSAC] physics world destroyed with %i still allocated bodies [MEMORY: %i bytes]\n", world->physicsBodiesCount, usedMemory);
+        else
+            printf("[PHYSAC] physics world destroyed successfully\n");
+    #endif
+
+    #if !defined(PHYSAC_NO_THREADS)
+        pthread_cond_destroy(&world->physicsThreadCondition);
+        pthread_mutex_destroy(&world->physicsThreadMutex);
+        pthread_mutex_destroy(&world->physicsStepMutex);
+    #endif
+
+    #if !defined(PHYSAC_NO_WORKERS)
+        StopPhysicsWorkers();
+    #endif
+
+    FreePhysicsBodies(world);
+    PHYSAC_FREE(world);
+}
+
+//----------------------------------------------------------------------------------
+// Module Internal Functions Definition
+//----------------------------------------------------------------------------------
+// Takes a free body id, growing bodies storage first if it is full
+static bool ReservePhysicsBodyId(PhysicsWorld world, unsigned int *id)
+{
+    // NOTE: Growing frees the arrays a step reads, callers hold the world lock so the physics thread is between steps
+    if ((world->physicsBodiesCount == world->bodiesCapacity) && !GrowPhysicsBodies(world))
+        return false;
+
+    // Every body holds one slot and there are as many slots as bodies capacity, so a slot is always left here
+    int slot = world->freeBodySlot;
+
+    if (slot != -1)
+        world->freeBodySlot = world->bodySlots[slot].next;
+    else
+    {
+        slot = world->bodySlotsCount;
+        world->bodySlots[slot].generation = 0;
+        world->bodySlotsCount++;
+    }
+
+    world->bodySlots[slot].next = -1;
+    *id = (world->bodySlots[slot].generation << PHYSAC_BODY_SLOT_BITS) | (unsigned int)slot;
+
+    return true;
+}
+
+// Puts the slot of a destroyed body id back on the free list with the next generation
+static void ReleasePhysicsBodyId(PhysicsWorld world, unsigned int id)
+{
+    int slot = (int)(id & PHYSAC_BODY_SLOT_MASK);
+
+    // Newer bodies in this slot get other ids, so neither cached contacts nor snapshot lookups mix them up with this one
+    world->bodySlots[slot].generation = (world->bodySlots[slot].generation + 1) & (0xffffffffu >> PHYSAC_BODY_SLOT_BITS);
+    world->bodySlots[slot].next = world->freeBodySlot;
+    world->freeBodySlot = slot;
+}
+
+// Doubles the capacity of every per body array of a world
+// NOTE: Arrays already grown stay valid if a later one fails, they are grown again on the next attempt
+static bool GrowPhysicsBodies(PhysicsWorld world)
+{
+    unsigned int capacity = ((world->bodiesCapacity > 0) ? world->bodiesCapacity*2 : PHYSAC_BODIES_CAPACITY);
+    unsigned int count = world->physicsBodiesCount;
+
+    if ((capacity == 0) || (capacity > (PHYSAC_BODY_SLOT_MASK + 1)))
+        return false;
+
+    // Island arrays only hold data during a step, they are grown empty
+    bool grown = GrowPhysicsArray((void **)&world->bodies, count, capacity, sizeof(PhysicsBody)) &&
+                 GrowPhysicsArray((void **)&world->broadphaseBodies, world->broadphaseBodiesCount, capacity, sizeof(PhysicsBody)) &&
+                 GrowPhysicsArray((void **)&world->bodySlots, world->bodySlotsCount, capacity, sizeof(PhysicsBodySlot)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.positionX, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.positionY, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.velocityX, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.velocityY, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.forceX, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.forceY, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.orient, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.previousPositionX, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.previousPositionY, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.previousOrient, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.angularVelocity, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.torque, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.inverseMass, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.inverseInertia, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.enabledMask, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.dynamicMask, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.gravityMask, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->bodiesState.rotationMask, count, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->islandParents, 0, capacity, sizeof(int)) &&
+                 GrowPhysicsArray((void **)&world->islandSleepTimes, 0, capacity, sizeof(float)) &&
+                 GrowPhysicsArray((void **)&world->islandIds, 0, capacity, sizeof(int)) &&
+                 GrowPhysicsArray((void **)&world->islandManifoldsStart, 0, capacity + 1, sizeof(int)) &&
+                 GrowPhysicsArray((void **)&world->islandIterations, 0, capacity, sizeof(int)) &&
+                 GrowPhysicsArray((void **)&world->islandTasks, 0, capacity, sizeof(int)) &&
+                 GrowPhysicsArray((void **)&world->islandOrder, 0, capacity, sizeof(int));
+
+    if (grown)
+    {
+        world->bodiesCapacity = capacity;
+
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] physics world bodies storage grown to %u bodies\n", capacity);
+        #endif
+    }
+
+    return grown;
+}
+
+// Doubles the capacity of the manifolds arena of a world, its contact cache follows
+// NOTE: Only called while the arena is full, never while manifolds pointers are held
+static bool GrowPhysicsManifolds(PhysicsWorld world)
+{
+    unsigned int capacity = ((world->manifoldsCapacity > 0) ? world->manifoldsCapacity*2 : PHYSAC_MANIFOLDS_CAPACITY);
+    unsigned int slots = 1;
+
+    if ((capacity == 0) || (capacity > (0xffffffffu/4)))
+        return false;
+
+    // Half of the contact cache stays empty at most, so its probing chains remain short
+    while (slots < capacity*2)
+        slots *= 2;
+
+    PhysicsContactCacheSlot *cache = (PhysicsContactCacheSlot *)PHYSAC_MALLOC(slots*sizeof(PhysicsContactCacheSlot));
+
+    if (cache == NULL)
+        return false;
+
+    // Island manifolds only hold data during a step, they are grown empty
+    bool grown = GrowPhysicsArray((void **)&world->manifolds, world->physicsManifoldsCount, capacity, sizeof(PhysicsManifoldData)) &&
+                 GrowPhysicsArray((void **)&world->islandManifolds, 0, capacity, sizeof(int));
+
+    if (!grown)
+    {
+        PHYSAC_FREE(cache);
+        return false;
+    }
+
+    // Contacts of the last step are still read by this one, they are hashed again into the bigger table
+    memset(cache, 0, slots*sizeof(PhysicsContactCacheSlot));
+
+    for (unsigned int i = 0; i < world->contactCacheSlots; i++)
+    {
+        if (world->contactCache[i].stamp != world->contactCacheStamp)
+            continue;
+
+        uint64_t key = world->contactCache[i].key;
+        unsigned int slot = (unsigned int)(key*0x9E3779B97F4A7C15ull >> 32) & (slots - 1);
+
+        while (cache[slot].stamp == world->contactCacheStamp)
+            slot = (slot + 1) & (slots - 1);
+
+        cache[slot] = world->contactCache[i];
+    }
+
+    if (world->contactCache != NULL)
+        PHYSAC_FREE(world->contactCache);
+
+    world->contactCache = cache;
+    world->contactCacheSlots = slots;
+    world->manifoldsCapacity = capacity;
+
+    #if defined(PHYSAC_DEBUG)
+        printf("[PHYSAC] physics world manifolds arena grown to %u manifolds\n", capacity);
+    #endif
+
+    return true;
+}
+
+// Moves the first count elements of an array into a new allocation, keeps it untouched on failure
+static bool GrowPhysicsArray(void **array, unsigned int count, unsigned int capacity, size_t size)
+{
+    void *grown = PHYSAC_MALLOC(capacity*size);
+
+    if (grown == NULL)
+        return false;
+
+    if (count > 0)
+        memcpy(grown, *array, count*size);
+
+    if (*array != NULL)
+        PHYSAC_FREE(*array);
+
+    *array = grown;
+
+    return true;
+}
+
+// Frees every per body array, manifolds arena and snapshot of a world
+static void FreePhysicsBodies(PhysicsWorld world)
+{
+    void *arrays[] = {
+        world->bodies, world->broadphaseBodies, world->bodySlots,
+        world->bodiesState.positionX, world->bodiesState.positionY, world->bodiesState.velocityX, world->bodiesState.velocityY,
+        world->bodiesState.forceX, world->bodiesState.forceY, world->bodiesState.orient,
+        world->bodiesState.previousPositionX, world->bodiesState.previousPositionY, world->bodiesState.previousOrient,
+        world->bodiesState.angularVelocity, world->bodiesState.torque, world->bodiesState.inverseMass, world->bodiesState.inverseInertia,
+        world->bodiesState.enabledMask, world->bodiesState.dynamicMask, world->bodiesState.gravityMask, world->bodiesState.rotationMask,
+        world->islandParents, world->islandSleepTimes, world->islandIds, world->islandManifoldsStart,
+        world->islandIterations, world->islandTasks, world->islandOrder,
+        world->manifolds, world->islandManifolds, world->contactCache,
+        world->snapshots[0].bodies, world->snapshots[0].indices,
+        world->snapshots[1].bodies, world->snapshots[1].indices,
+        world->snapshots[2].bodies, world->snapshots[2].indices
+    };
+
+    for (int i = 0; i < (int)(sizeof(arrays)/sizeof(arrays[0])); i++)
+    {
+        if (arrays[i] != NULL)
+            PHYSAC_FREE(arrays[i]);
+    }
+}
+
+// Creates a random polygon shape with max vertex distance from polygon pivot
+static PolygonData CreateRandomPolygon(float radius, int sides)
+{
+    PolygonData data = { 0 };
+    data.vertexCount = sides;
+
+    // Calculate polygon vertices positions
+    for (int i = 0; i < data.vertexCount; i++)
+    {
+        data.positions[i].x = cosf(360.0f/sides*i*PHYSAC_DEG2RAD)*radius;
+        data.positions[i].y = sinf(360.0f/sides*i*PHYSAC_DEG2RAD)*radius;
+    }
+
+    // Calculate polygon faces normals
+    for (int i = 0; i < data.vertexCount; i++)
+    {
+        int nextIndex = (((i + 1) < sides) ? (i + 1) : 0);
+        Vector2 face = Vector2Subtract(data.positions[nextIndex], data.positions[i]);
+
+        data.normals[i] = (Vector2){ face.y, -face.x };
+        MathNormalize(&data.normals[i]);
+    }
+
+    return data;
+}
+
+// Creates a rectangle polygon shape based on a min and max positions
+static PolygonData CreateRectanglePolygon(Vector2 pos, Vector2 size)
+{
+    PolygonData data = { 0 };
+    data.vertexCount = 4;
+
+    // Calculate polygon vertices positions
+    data.positions[0] = (Vector2){ pos.x + size.x/2, pos.y - size.y/2 };
+    data.positions[1] = (Vector2){ pos.x + size.x/2, pos.y + size.y/2 };
+    data.positions[2] = (Vector2){ pos.x - size.x/2, pos.y + size.y/2 };
+    data.positions[3] = (Vector2){ pos.x - size.x/2, pos.y - size.y/2 };
+
+    // Calculate polygon faces normals
+    for (int i = 0; i < data.vertexCount; i++)
+    {
+        int nextIndex = (((i + 1) < data.vertexCount) ? (i + 1) : 0);
+        Vector2 face = Vector2Subtract(data.positions[nextIndex], data.positions[i]);
+
+        data.normals[i] = (Vector2){ face.y, -face.x };
+        MathNormalize(&data.normals[i]);
+    }
+
+    return data;
+}
+
+// Appends the packed state of a new physics body
+static void InitPhysicsBodyState(PhysicsBody body, Vector2 pos)
+{
+    PhysicsWorld world = body->world;
+    unsigned int index = world->physicsBodiesCount;
+    body->index = index;
+
+    world->bodiesState.positionX[index] = pos.x;
+    world->bodiesState.positionY[index] = pos.y;
+    world->bodiesState.velocityX[index] = 0.0f;
+    world->bodiesState.velocityY[index] = 0.0f;
+    world->bodiesState.forceX[index] = 0.0f;
+    world->bodiesState.forceY[index] = 0.0f;
+    world->bodiesState.orient[index] = 0.0f;
+    world->bodiesState.previousPositionX[index] = pos.x;
+    world->bodiesState.previousPositionY[index] = pos.y;
+    world->bodiesState.previousOrient[index] = 0.0f;
+    world->bodiesState.angularVelocity[index] = 0.0f;
+    world->bodiesState.torque[index] = 0.0f;
+    world->bodiesState.inverseMass[index] = 0.0f;
+    world->bodiesState.inverseInertia[index] = 0.0f;
+
+    world->snapshotDirty = true;
+}
+
+// Sets physics body mass and inertia and their inverse values
+static void SetPhysicsBodyMassData(PhysicsBody body, float mass, float inertia)
+{
+    body->mass = mass;
+    body->inertia = inertia;
+    body->world->bodiesState.inverseMass[body->index] = ((mass != 0.0f) ? 1.0f/mass : 0.0f);
+    body->world->bodiesState.inverseInertia[body->index] = ((inertia != 0.0f) ? 1.0f/inertia : 0.0f);
+}
+
+// Copies bodies flags into packed state masks used by integration kernels
+static void UpdatePhysicsBodiesMasks(PhysicsWorld world)
+{
+    for (int i = 0; i < world->physicsBodiesCount; i++)
+    {
+        PhysicsBody body = world->bodies[i];
+
+        world->bodiesState.enabledMask[i] = ((body->enabled && !body->isSleeping) ? 1.0f : 0.0f);
+        world->bodiesState.dynamicMask[i] = ((IsPhysicsBodyDynamic(body) && !body->isSleeping) ? 1.0f : 0.0f);
+        world->bodiesState.gravityMask[i] = (body->useGravity ? 1.0f : 0.0f);
+        world->bodiesState.rotationMask[i] = (body->freezeOrient ? 0.0f : 1.0f);
+    }
+}
+
+// Returns true if physics body is enabled and has finite mass
+static bool IsPhysicsBodyDynamic(PhysicsBody body)
+{
+    return (body->enabled && (body->world->bodiesState.inverseMass[body->index] != 0.0f));
+}
+
+// Returns contact island root of a body index
+static int FindPhysicsIsland(PhysicsWorld world, int index)
+{
+    while (world->islandParents[index] != index)
+    {
+        world->islandParents[index] = world->islandParents[world->islandParents[index]];
+        index = world->islandParents[index];
+    }
+
+    return index;
+}
+
+// Joins touching dynamic bodies into contact islands and groups manifolds by island
+static void BuildPhysicsIslands(PhysicsWorld world)
+{
+    for (int i = 0; i < world->physicsBodiesCount; i++)
+    {
+        world->islandParents[i] = i;
+        world->islandIds[i] = -1;
+    }
+
+    // Static bodies do not link islands together, they never move while solving
+    for (int i = 0; i < world->physicsManifoldsCount; i++)
+    {
+        PhysicsBody bodyA = world->manifolds[i].bodyA;
+        PhysicsBody bodyB = world->manifolds[i].bodyB;
+
+        if (IsPhysicsBodyDynamic(bodyA) && IsPhysicsBodyDynamic(bodyB))
+            world->islandParents[FindPhysicsIsland(world, bodyA->index)] = FindPhysicsIsland(world, bodyB->index);
+    }
+
+    // Number islands in order of their first manifold and count their manifolds, so grouping never depends on scheduling
+    world->solverIslandsCount = 0;
+
+    for (int i = 0; i < world->physicsManifoldsCount; i++)
+    {
+        PhysicsManifold manifold = &world->manifolds[i];
+        PhysicsBody body = (IsPhysicsBodyDynamic(manifold->bodyA) ? manifold->bodyA : manifold->bodyB);
+        int root = FindPhysicsIsland(world, body->index);
+
+        if (world->islandIds[root] < 0)
+        {
+            world->islandIds[root] = world->solverIslandsCount;
+            world->islandManifoldsStart[world->solverIslandsCount] = 0;
+            world->solverIslandsCount++;
+        }
+
+        world->islandManifoldsStart[world->islandIds[root]]++;
+    }
+
+    // Counts become range ends, filling ranges backwards moves them to range starts and keeps arena order within an island
+    int offset = 0;
+
+    for (int i = 0; i < world->solverIslandsCount; i++)
+    {
+        offset += world->islandManifoldsStart[i];
+        world->islandManifoldsStart[i] = offset;
+    }
+
+    world->islandManifoldsStart[world->solverIslandsCount] = offset;
+
+    for (int i = world->physicsManifoldsCount - 1; i >= 0; i--)
+    {
+        PhysicsManifold manifold = &world->manifolds[i];
+        PhysicsBody body = (IsPhysicsBodyDynamic(manifold->bodyA) ? manifold->bodyA : manifold->bodyB);
+        int island = world->islandIds[FindPhysicsIsland(world, body->index)];
+
+        world->islandManifoldsStart[island]--;
+        world->islandManifolds[world->islandManifoldsStart[island]] = i;
+    }
+}
+
+// Solves collisions of every contact island, on the worker pool when the step has enough manifolds
+static void SolvePhysicsIslands(PhysicsWorld world)
+{
+    bool solved = false;
+
+    #if !defined(PHYSAC_NO_WORKERS)
+        int workers = physicsWorkers.workersCount;
+
+        if ((world->solverSettings.workers > 0) && (world->solverSettings.workers < workers))
+            workers = world->solverSettings.workers;
+
+        if (workers > world->solverIslandsCount)
+            workers = world->solverIslandsCount;
+
+        // Another world stepping on its own thread may own the pool, solving alone beats waiting for it
+        if ((workers > 1) && (world->physicsManifoldsCount >= PHYSAC_PARALLEL_MANIFOLDS) && (pthread_mutex_trylock(&physicsWorkers.batchMutex) == 0))
+        {
+            RunPhysicsWorkersBatch(world, workers);
+            pthread_mutex_unlock(&physicsWorkers.batchMutex);
+            solved = true;
+        }
+    #endif
+
+    if (!solved)
+    {
+        for (int i = 0; i < world->solverIslandsCount; i++)
+            SolvePhysicsIsland(world, i);
+    }
+
+    // Islands run side by side, so a step costs as many iterations as its slowest island
+    int iterations = 0;
+
+    for (int i = 0; i < world->solverIslandsCount; i++)
+        iterations = max(iterations, world->islandIterations[i]);
+
+    world->iterationsCount += iterations;
+}
+
+// Initializes and iterates collision impulses of a single contact island
+static void SolvePhysicsIsland(PhysicsWorld world, int island)
+{
+    int start = world->islandManifoldsStart[island];
+    int end = world->islandManifoldsStart[island + 1];
+
+    // Initialize physics manifolds to solve collisions
+    for (int i = start; i < end; i++)
+        InitializePhysicsManifolds(&world->manifolds[world->islandManifolds[i]]);
+
+    // Integrate physics collisions impulses to solve collisions
+    int iterations = 0;
+
+    for (int i = 0; i < world->solverSettings.iterations; i++)
+    {
+        float residual = 0.0f;
+
+        for (int j = start; j < end; j++)
+        {
+            float manifoldResidual = IntegratePhysicsImpulses(&world->manifolds[world->islandManifolds[j]]);
+            residual = max(residual, manifoldResidual);
+        }
+
+        iterations++;
+
+        // Warm started resting contacts converge within a couple of iterations, the rest would not change anything
+        if (world->solverSettings.adaptiveIterations && (residual < world->solverSettings.adaptiveThreshold))
+            break;
+    }
+
+    world->islandIterations[island] = iterations;
+}
+
+#if !defined(PHYSAC_NO_WORKERS)
+// Returns the amount of physical cores, logical processors when topology is unknown
+static int GetPhysicsCoresCount(void)
+{
+    int processors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (processors < 1)
+        return 1;
+
+    #if defined(__linux__)
+        // A processor counts as a core when it is the first of its hardware thread siblings
+        int cores = 0;
+
+        for (int i = 0; i < processors; i++)
+        {
+            char path[96];
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/topology/thread_siblings_list", i);
+
+            FILE *file = fopen(path, "r");
+            int firstSibling = -1;
+
+            if (file == NULL)
+                return processors;
+
+            if (fscanf(file, "%i", &firstSibling) != 1)
+                firstSibling = i;
+
+            fclose(file);
+
+            if (firstSibling == i)
+                cores++;
+        }
+
+        return ((cores > 0) ? cores : processors);
+    #else
+        return processors;
+    #endif
+}
+
+// Starts the worker pool with the first world
+static void StartPhysicsWorkers(void)
+{
+    pthread_mutex_lock(&physicsWorkers.mutex);
+
+    if (physicsWorkers.worldsCount == 0)
+    {
+        int workers = GetPhysicsCoresCount();
+
+        if (workers > PHYSAC_MAX_WORKERS)
+            workers = PHYSAC_MAX_WORKERS;
+
+        // Workers count batches from 0, a batch posted before a new worker first waits is not missed
+        physicsWorkers.running = true;
+        physicsWorkers.generation = 0;
+        physicsWorkers.workersCount = 1;
+
+        // Worker 0 is whichever thread runs the step, only the others get a thread
+        for (int i = 1; i < workers; i++)
+        {
+            if (pthread_create(&physicsWorkers.threads[i], NULL, &PhysicsWorkerLoop, (void *)(intptr_t)i) != 0)
+                break;
+
+            physicsWorkers.workersCount++;
+        }
+
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] physics worker pool started with %i workers\n", physicsWorkers.workersCount);
+        #endif
+    }
+
+    physicsWorkers.worldsCount++;
+    pthread_mutex_unlock(&physicsWorkers.mutex);
+}
+
+// Stops the worker pool with the last world
+static void StopPhysicsWorkers(void)
+{
+    pthread_mutex_lock(&physicsWorkers.mutex);
+    physicsWorkers.worldsCount--;
+
+    if (physicsWorkers.worldsCount > 0)
+    {
+        pthread_mutex_unlock(&physicsWorkers.mutex);
+        return;
+    }
+
+    physicsWorkers.running = false;
+    pthread_cond_broadcast(&physicsWorkers.condition);
+    pthread_mutex_unlock(&physicsWorkers.mutex);
+
+    for (int i = 1; i < physicsWorkers.workersCount; i++)
+        pthread_join(physicsWorkers.threads[i], NULL);
+
+    physicsWorkers.workersCount = 0;
+}
+
+// Worker thread function, runs every batch it is woken up for
+static void *PhysicsWorkerLoop(void *arg)
+{
+    int worker = (int)(intptr_t)arg;
+    unsigned int generation = 0;
+
+    pthread_mutex_lock(&physicsWorkers.mutex);
+
+    while (true)
+    {
+        while (physicsWorkers.running && (physicsWorkers.generation == generation))
+            pthread_cond_wait(&physicsWorkers.condition, &physicsWorkers.mutex);
+
+        if (!physicsWorkers.running)
+            break;
+
+        generation = physicsWorkers.generation;
+
+        // Batches smaller than the pool leave the last workers out, they wait for the next one
+        if (worker >= physicsWorkers.batchWorkers)
+            continue;
+
+        pthread_mutex_unlock(&physicsWorkers.mutex);
+        RunPhysicsWorkerTasks(worker);
+        pthread_mutex_lock(&physicsWorkers.mutex);
+
+        physicsWorkers.busyWorkers--;
+
+        if (physicsWorkers.busyWorkers == 0)
+            pthread_cond_signal(&physicsWorkers.doneCondition);
+    }
+
+    pthread_mutex_unlock(&physicsWorkers.mutex);
+
+    return NULL;
+}
+
+// Solves islands of a worker queue, then steals from the others until every queue is empty
+static void RunPhysicsWorkerTasks(int worker)
+{
+    PhysicsWorld world = physicsWorkers.world;
+    int workers = physicsWorkers.batchWorkers;
+
+    while (true)
+    {
+        int task = PopPhysicsWorkerTask(&physicsWorkers.queues[worker]);
+
+        // Queues only drain during a batch, so a single pass finding all of them empty ends it for this worker
+        for (int i = 1; (task < 0) && (i < workers); i++)
+        {
+            PhysicsWorkerQueue *victim = &physicsWorkers.queues[(worker + i)%workers];
+
+            do task = StealPhysicsWorkerTask(victim);
+            while (task == -2);
+        }
+
+        if (task < 0)
+            break;
+
+        SolvePhysicsIsland(world, world->islandTasks[task]);
+    }
+}
+
+// Takes the last task of a worker own queue, -1 if empty
+static int PopPhysicsWorkerTask(PhysicsWorkerQueue *queue)
+{
+    int bottom = atomic_load(&queue->bottom) - 1;
+    atomic_store(&queue->bottom, bottom);
+    int top = atomic_load(&queue->top);
+
+    if (top > bottom)
+    {
+        atomic_store(&queue->bottom, bottom + 1);
+        return -1;
+    }
+
+    // The last task may be stolen at the same time, whoever moves top first gets it
+    if (top == bottom)
+    {
+        int task = (atomic_compare_exchange_strong(&queue->top, &top, top + 1) ? bottom : -1);
+        atomic_store(&queue->bottom, bottom + 1);
+        return task;
+    }
+
+    return bottom;
+}
+
+// Takes the first task of another worker queue, -1 if empty and -2 if another worker won the race
+static int StealPhysicsWorkerTask(PhysicsWorkerQueue *queue)
+{
+    int top = atomic_load(&queue->top);
+    int bottom = atomic_load(&queue->bottom);
+
+    if (top >= bottom)
+        return -1;
+
+    return (atomic_compare_exchange_strong(&queue->top, &top, top + 1) ? top : -2);
+}
+
+// Deals islands to workers queues and solves them together with the pool
+static void RunPhysicsWorkersBatch(PhysicsWorld world, int workers)
+{
+    // Biggest islands first, dealt round robin so every worker starts with a similar load
+    for (int i = 0; i < world->solverIslandsCount; i++)
+    {
+        int size = world->islandManifoldsStart[i + 1] - world->islandManifoldsStart[i];
+        int j = i;
+
+        while (j > 0)
+        {
+            int previous = world->islandTasks[j - 1];
+
+            if (world->islandManifoldsStart[previous + 1] - world->islandManifoldsStart[previous] >= size)
+                break;
+
+            world->islandTasks[j] = previous;
+            j--;
+        }
+
+        world->islandTasks[j] = i;
+    }
+
+    // Worker w gets sorted islands w, w + workers... as one slice, biggest at the bottom where the owner pops first
+    int offset = 0;
+
+    for (int i = 0; i < world->solverIslandsCount; i++)
+        world->islandOrder[i] = world->islandTasks[i];
+
+    for (int w = 0; w < workers; w++)
+    {
+        int count = (world->solverIslandsCount - w + workers - 1)/workers;
+
+        for (int k = 0; k < count; k++)
+            world->islandTasks[offset + count - 1 - k] = world->islandOrder[w + k*workers];
+
+        atomic_store(&physicsWorkers.queues[w].top, offset);
+        atomic_store(&physicsWorkers.queues[w].bottom, offset + count);
+        offset += count;
+    }
+
+    pthread_mutex_lock(&physicsWorkers.mutex);
+    physicsWorkers.busyWorkers = workers - 1;
+    physicsWorkers.world = world;
+    physicsWorkers.batchWorkers = workers;
+    physicsWorkers.generation++;
+    pthread_cond_broadcast(&physicsWorkers.condition);
+    pthread_mutex_unlock(&physicsWorkers.mutex);
+
+    RunPhysicsWorkerTasks(0);
+
+    // Every queue is empty, the last stolen islands may still be solving
+    pthread_mutex_lock(&physicsWorkers.mutex);
+
+    while (physicsWorkers.busyWorkers > 0)
+        pthread_cond_wait(&physicsWorkers.doneCondition, &physicsWorkers.mutex);
+
+    pthread_mutex_unlock(&physicsWorkers.mutex);
+}
+#endif
+
+// Puts resting contact islands to sleep
+static void UpdatePhysicsSleeping(PhysicsWorld world)
+{
+    const float linearSqr = PHYSAC_SLEEP_LINEAR_VELOCITY*PHYSAC_SLEEP_LINEAR_VELOCITY;
+
+    // Accumulate resting time of awake dynamic bodies
+    for (int i = 0; i < world->physicsBodiesCount; i++)
+    {
+        PhysicsBody body = world->bodies[i];
+        world->islandSleepTimes[i] = PHYSAC_FLT_MAX;
+
+        if (IsPhysicsBodyDynamic(body) && !body->isSleeping)
+        {
+            float velocitySqr = world->bodiesState.velocityX[i]*world->bodiesState.velocityX[i] + world->bodiesState.velocityY[i]*world->bodiesState.velocityY[i];
+
+            if ((velocitySqr < linearSqr) && (fabsf(world->bodiesState.angularVelocity[i]) < PHYSAC_SLEEP_ANGULAR_VELOCITY))
+                body->sleepTime += world->deltaTime;
+            else
+                body->sleepTime = 0.0f;
+        }
+    }
+
+    // An island rests as long as its least resting body, islands were built by BuildPhysicsIslands() before solving
+    for (int i = 0; i < world->physicsBodiesCount; i++)
+    {
+        if (IsPhysicsBodyDynamic(world->bodies[i]))
+        {
+            int root = FindPhysicsIsland(world, i);
+            world->islandSleepTimes[root] = min(world->islandSleepTimes[root], world->bodies[i]->sleepTime);
+        }
+    }
+
+    for (int i = 0; i < world->physicsBodiesCount; i++)
+    {
+        PhysicsBody body = world->bodies[i];
+
+        if (!IsPhysicsBodyDynamic(body) || body->isSleeping)
+            continue;
+
+        int root = FindPhysicsIsland(world, i);
+
+        if (world->islandSleepTimes[root] >= PHYSAC_SLEEP_TIME)
+        {
+            body->isSleeping = true;
+            body->island = world->islandsCount + root + 1;
+            world->bodiesState.velocityX[i] = 0.0f;
+            world->bodiesState.velocityY[i] = 0.0f;
+            world->bodiesState.angularVelocity[i] = 0.0f;
+        }
+    }
+
+    world->islandsCount += world->physicsBodiesCount;
+}
+
+// Copies bodies transforms into the triple buffer and hands it to the reader
+static void PublishPhysicsSnapshot(PhysicsWorld world)
+{
+    PhysicsSnapshot *snapshot = &world->snapshots[world->snapshotWriteIndex];
+
+    // The written slot is only grown here by its owner, the reader keeps using its own slot meanwhile
+    if (snapshot->capacity < world->bodiesCapacity)
+    {
+        PhysicsBodySnapshot *bodies = (PhysicsBodySnapshot *)PHYSAC_MALLOC(world->bodiesCapacity*sizeof(PhysicsBodySnapshot));
+        int *indices = (int *)PHYSAC_MALLOC(world->bodiesCapacity*sizeof(int));
+
+        // Snapshot stays dirty and publishing is retried after the next step
+        if ((bodies == NULL) || (indices == NULL))
+        {
+            if (bodies != NULL)
+                PHYSAC_FREE(bodies);
+            if (indices != NULL)
+                PHYSAC_FREE(indices);
+
+            return;
+        }
+
+        if (snapshot->bodies != NULL)
+            PHYSAC_FREE(snapshot->bodies);
+        if (snapshot->indices != NULL)
+            PHYSAC_FREE(snapshot->indices);
+
+        snapshot->bodies = bodies;
+        snapshot->indices = indices;
+        snapshot->capacity = world->bodiesCapacity;
+    }
+
+    for (int i = 0; i < world->bodySlotsCount; i++)
+        snapshot->indices[i] = -1;
+
+    for (int i = 0; i < world->physicsBodiesCount; i++)
+    {
+        PhysicsBody body = world->bodies[i];
+
+        snapshot->bodies[i].id = body->id;
+        snapshot->bodies[i].position = (Vector2){ world->bodiesState.positionX[i], world->bodiesState.positionY[i] };
+        snapshot->bodies[i].orient = world->bodiesState.orient[i];
+        snapshot->bodies[i].previousPosition = (Vector2){ world->bodiesState.previousPositionX[i], world->bodiesState.previousPositionY[i] };
+        snapshot->bodies[i].previousOrient = world->bodiesState.previousOrient[i];
+        snapshot->bodies[i].aabb = GetPhysicsBodyAABB(body);
+
+        snapshot->indices[body->id & PHYSAC_BODY_SLOT_MASK] = i;
+    }
+
+    snapshot->bodiesCount = world->physicsBodiesCount;
+    snapshot->indicesCount = world->bodySlotsCount;
+    snapshot->stepsCount = world->stepsCount;
+    snapshot->time = world->currentTime - world->accumulator;
+    snapshot->deltaTime = world->deltaTime;
+    world->snapshotDirty = false;
+
+    // Swap written slot with the shared one, the reader picks it up on its next GetPhysicsSnapshot() call
+    #if !defined(PHYSAC_NO_THREADS)
+        world->snapshotWriteIndex = atomic_exchange_explicit(&world->snapshotShared, world->snapshotWriteIndex | PHYSAC_SNAPSHOT_FRESH, memory_order_acq_rel) & PHYSAC_SNAPSHOT_INDEX_MASK;
+    #else
+        unsigned int shared = world->snapshotShared;
+        world->snapshotShared = world->snapshotWriteIndex | PHYSAC_SNAPSHOT_FRESH;
+        world->snapshotWriteIndex = shared & PHYSAC_SNAPSHOT_INDEX_MASK;
+    #endif
+}
+
+// Waits for physics thread to finish its current step and keeps it from starting another
+static void LockPhysicsWorld(PhysicsWorld world)
+{
+    #if !defined(PHYSAC_NO_THREADS)
+        pthread_mutex_lock(&world->physicsStepMutex);
+    #else
+        (void)world;
+    #endif
+}
+
+// Lets physics thread step again
+static void UnlockPhysicsWorld(PhysicsWorld world)
+{
+    #if !defined(PHYSAC_NO_THREADS)
+        pthread_mutex_unlock(&world->physicsStepMutex);
+    #else
+        (void)world;
+    #endif
+}
+
+// Wakes up physics thread if it is blocked waiting for awake bodies
+static void SignalPhysicsThread(PhysicsWorld world)
+{
+    #if !defined(PHYSAC_NO_THREADS)
+        pthread_mutex_lock(&world->physicsThreadMutex);
+        world->physicsThreadWakeUp = true;
+        pthread_cond_signal(&world->physicsThreadCondition);
+        pthread_mutex_unlock(&world->physicsThreadMutex);
+    #else
+        (void)world;
+    #endif
+}
+
+#if !defined(PHYSAC_NO_THREADS)
+// Physics loop thread function
+static void *PhysicsLoop(void *arg)
+{
+    PhysicsWorld world = (PhysicsWorld)arg;
+
+    #if defined(PHYSAC_DEBUG)
+        printf("[PHYSAC] physics thread created successfully\n");
+    #endif
 
-    // Generate new collision information
-    for (int i = 0; i < physicsBodiesCount; i++)
+    // Physics update loop
+    while (world->physicsThreadEnabled)
     {
-        PhysicsBody bodyA = bodies[i];
+        RunPhysicsStep(world);
 
-        if (bodyA != NULL)
-        {
-            for (int j = i + 1; j < physicsBodiesCount; j++)
-            {
-                PhysicsBody bodyB = bodies[j];
+        if (world->physicsIdle)
+            WaitPhysicsWakeUp(world);
+        else
+            WaitPhysicsStepDeadline(world);
+    }
 
-                if (bodyB != NULL)
-                {
-                    if ((bodyA->inverseMass == 0) && (bodyB->inverseMass == 0))
-                        continue;
+    return NULL;
+}
 
-                    PhysicsManifold manifold = CreatePhysicsManifold(bodyA, bodyB);
-                    SolvePhysicsManifold(manifold);
+// Blocks physics thread until a body is created or woken up
+static void WaitPhysicsWakeUp(PhysicsWorld world)
+{
+    pthread_mutex_lock(&world->physicsThreadMutex);
 
-                    if (manifold->contactsCount > 0)
-                    {
-                        // Create a new manifold with same information as previously solved manifold and add it to the manifolds pool last slot
-                        PhysicsManifold newManifold = CreatePhysicsManifold(bodyA, bodyB);
-                        newManifold->penetration = manifold->penetration;
-                        newManifold->normal = manifold->normal;
-                        newManifold->contacts[0] = manifold->contacts[0];
-                        newManifold->contacts[1] = manifold->contacts[1];
-                        newManifold->contactsCount = manifold->contactsCount;
-                        newManifold->restitution = manifold->restitution;
-                        newManifold->dynamicFriction = manifold->dynamicFriction;
-                        newManifold->staticFriction = manifold->staticFriction;
-                    }
-                }
-            }
+    // NOTE: Time spent blocked is not simulated, RunPhysicsStep() drops it because the world was idle
+    // Bodies are not counted here, they can be created meanwhile and every change that wakes one signals the thread
+    while (world->physicsThreadEnabled && !world->physicsThreadWakeUp)
+        pthread_cond_wait(&world->physicsThreadCondition, &world->physicsThreadMutex);
+
+    world->physicsThreadWakeUp = false;
+    pthread_mutex_unlock(&world->physicsThreadMutex);
+}
+
+// Sleeps physics thread until next fixed time step is due
+static void WaitPhysicsStepDeadline(PhysicsWorld world)
+{
+    // Next step runs when accumulated time reaches deltaTime, see RunPhysicsStep()
+    double deadline = world->startTime + world->deltaTime - world->accumulator;
+
+    #if defined(__linux__)
+        uint64_t nanoseconds = (uint64_t)baseTime + (uint64_t)(deadline*1000000.0);
+        struct timespec wakeTime = { (time_t)(nanoseconds/1000000000), (long)(nanoseconds%1000000000) };
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL) == EINTR)
+        {
+            // Interrupted by a signal handler, keep sleeping until deadline
+        }
+    #else
+        while (world->physicsThreadEnabled && (GetCurrentTime() < deadline))
+        {
+            // Busy wait, no absolute monotonic sleep available on this platform
         }
+    #endif
+}
+#endif
+
+// Physics steps calculations (dynamics, collisions and position corrections)
+static void PhysicsStep(PhysicsWorld world)
+{
+    // Keep transforms of the last step so renderers can blend between steps
+    for (int i = 0; i < world->physicsBodiesCount; i++)
+    {
+        world->bodiesState.previousPositionX[i] = world->bodiesState.positionX[i];
+        world->bodiesState.previousPositionY[i] = world->bodiesState.positionY[i];
+        world->bodiesState.previousOrient[i] = world->bodiesState.orient[i];
     }
 
-    // Integrate forces to physics bodies
-    for (int i = 0; i < physicsBodiesCount; i++)
+    // Clear previous generated collisions information
+    world->physicsManifoldsCount = 0;
+
+    // Nothing can move until a body is woken up by a force, a transform change or a new body
+    if (GetPhysicsAwakeBodiesCount(world) == 0)
     {
-        PhysicsBody body = bodies[i];
-        
-        if (body != NULL)
-            IntegratePhysicsForces(body);
+        world->broadphaseCulledPairs = 0;
+        return;
     }
 
-    // Initialize physics manifolds to solve collisions
-    for (int i = 0; i < physicsManifoldsCount; i++)
+    // Update current steps count
+    world->stepsCount++;
+
+    // Reset physics bodies grounded state
+    for (int i = 0; i < world->physicsBodiesCount; i++)
     {
-        PhysicsManifold manifold = contacts[i];
-        
-        if (manifold != NULL)
-            InitializePhysicsManifolds(manifold);
+        PhysicsBody body = world->bodies[i];
+        body->isGrounded = false;
     }
 
-    // Integrate physics collisions impulses to solve collisions
-    for (int i = 0; i < PHYSAC_COLLISION_ITERATIONS; i++)
+    // Generate new collision information, only bodies whose bounding boxes overlap reach the narrowphase
+    UpdatePhysicsBroadphase(world);
+
+    unsigned int testedPairs = 0;
+
+    for (int i = 0; i < world->broadphaseBodiesCount; i++)
     {
-        for (int j = 0; j < physicsManifoldsCount; j++)
+        PhysicsBody bodyA = world->broadphaseBodies[i];
+
+        for (int j = i + 1; j < world->broadphaseBodiesCount; j++)
         {
-            PhysicsManifold manifold = contacts[i];
-            
-            if (manifold != NULL)
-                IntegratePhysicsImpulses(manifold);
+            PhysicsBody bodyB = world->broadphaseBodies[j];
+
+            // Bodies are sorted by minimum x, so no later body can overlap body A
+            if (bodyB->aabb.min.x > bodyA->aabb.max.x)
+                break;
+
+            if ((bodyB->aabb.min.y > bodyA->aabb.max.y) || (bodyA->aabb.min.y > bodyB->aabb.max.y))
+                continue;
+
+            // Static and sleeping bodies do not need contacts between them
+            if ((!IsPhysicsBodyDynamic(bodyA) || bodyA->isSleeping) && (!IsPhysicsBodyDynamic(bodyB) || bodyB->isSleeping))
+                continue;
+
+            GeneratePhysicsContacts(bodyA, bodyB);
+            testedPairs++;
         }
     }
 
+    world->broadphaseCulledPairs = world->broadphaseBodiesCount*(world->broadphaseBodiesCount - 1)/2 - testedPairs;
+
+    // Integrate forces to physics bodies
+    UpdatePhysicsBodiesMasks(world);
+    IntegratePhysicsForces(world);
+
+    // Group manifolds by contact island, islands only share static bodies so each one is solved on its own
+    BuildPhysicsIslands(world);
+
+    // Initialize physics manifolds and integrate collisions impulses of every island
+    SolvePhysicsIslands(world);
+
+    // Keep accumulated impulses to warm start contacts that still exist on next step
+    StorePhysicsContactCache(world);
+
     // Integrate velocity to physics bodies
-    for (int i = 0; i < physicsBodiesCount; i++)
+    IntegratePhysicsVelocity(world);
+
+    // Correct physics bodies positions based on manifolds collision information
+    for (int i = 0; i < world->physicsManifoldsCount; i++)
+        CorrectPhysicsPositions(&world->manifolds[i]);
+
+    // Clear physics bodies forces
+    for (int i = 0; i < world->physicsBodiesCount; i++)
     {
-        PhysicsBody body = bodies[i];
-        
-        if (body != NULL)
-            IntegratePhysicsVelocity(body);
+        world->bodiesState.forceX[i] = 0.0f;
+        world->bodiesState.forceY[i] = 0.0f;
+        world->bodiesState.torque[i] = 0.0f;
     }
 
-    // Correct physics bodies positions based on manifolds collision information
-    for (int i = 0; i < physicsManifoldsCount; i++)
+    // Put resting islands to sleep
+    UpdatePhysicsSleeping(world);
+}
+
+// Computes the world space bounding box of a physics body shape
+static PhysicsAABB GetPhysicsBodyAABB(PhysicsBody body)
+{
+    Vector2 position = GetPhysicsBodyPosition(body);
+    PhysicsAABB aabb = { position, position };
+
+    switch (body->shape.type)
     {
-        PhysicsManifold manifold = contacts[i];
-        
-        if (manifold != NULL)
-            CorrectPhysicsPositions(manifold);
+        case PHYSICS_CIRCLE:
+        {
+            aabb.min.x -= body->shape.radius;
+            aabb.min.y -= body->shape.radius;
+            aabb.max.x += body->shape.radius;
+            aabb.max.y += body->shape.radius;
+        } break;
+        case PHYSICS_POLYGON:
+        {
+            PolygonData *vertexData = &body->shape.vertexData;
+            aabb.min = (Vector2){ PHYSAC_FLT_MAX, PHYSAC_FLT_MAX };
+            aabb.max = (Vector2){ -PHYSAC_FLT_MAX, -PHYSAC_FLT_MAX };
+
+            for (int i = 0; i < vertexData->vertexCount; i++)
+            {
+                Vector2 vertex = Vector2Add(position, Mat2MultiplyVector2(body->shape.transform, vertexData->positions[i]));
+
+                aabb.min.x = min(aabb.min.x, vertex.x);
+                aabb.min.y = min(aabb.min.y, vertex.y);
+                aabb.max.x = max(aabb.max.x, vertex.x);
+                aabb.max.y = max(aabb.max.y, vertex.y);
+            }
+        } break;
+        default: break;
     }
 
-    // Clear physics bodies forces
-    for (int i = 0; i < physicsBodiesCount; i++)
+    return aabb;
+}
+
+// Updates bodies bounding boxes and keeps broadphase array sorted along x axis
+static void UpdatePhysicsBroadphase(PhysicsWorld world)
+{
+    for (int i = 0; i < world->broadphaseBodiesCount; i++)
+        world->broadphaseBodies[i]->aabb = GetPhysicsBodyAABB(world->broadphaseBodies[i]);
+
+    // Insertion sort, bodies barely move between steps so the array is almost sorted already
+    for (int i = 1; i < world->broadphaseBodiesCount; i++)
     {
-        PhysicsBody body = bodies[i];
-        
-        if (body != NULL)
+        PhysicsBody body = world->broadphaseBodies[i];
+        int j = i - 1;
+
+        while ((j >= 0) && (world->broadphaseBodies[j]->aabb.min.x > body->aabb.min.x))
         {
-            body->force = PHYSAC_VECTOR_ZERO;
-            body->torque = 0.0f;
+            world->broadphaseBodies[j + 1] = world->broadphaseBodies[j];
+            world->broadphaseBodies[j + 1]->broadphaseIndex = j + 1;
+            j--;
         }
+
+        world->broadphaseBodies[j + 1] = body;
+        body->broadphaseIndex = j + 1;
+    }
+}
+
+// Runs narrowphase between two bodies and stores the manifold if they collide
+static void GeneratePhysicsContacts(PhysicsBody a, PhysicsBody b)
+{
+    // Broadphase order changes as bodies move, ordering pairs by id keeps contacts features stable between steps
+    if (a->id > b->id)
+    {
+        PhysicsBody swap = a;
+        a = b;
+        b = swap;
+    }
+
+    PhysicsManifold manifold = CreatePhysicsManifold(a, b);
+
+    if (manifold == NULL)
+        return;
+
+    SolvePhysicsManifold(manifold);
+
+    // Keep the arena slot only if bodies are in contact, otherwise next pair reuses it
+    if (manifold->contactsCount > 0)
+    {
+        LoadPhysicsContactCache(manifold);
+        a->world->physicsManifoldsCount++;
+
+        // A moving body touching a sleeping one wakes up its whole island
+        if (a->isSleeping && IsPhysicsBodyDynamic(b) && !b->isSleeping)
+            WakeUpPhysicsBody(a);
+        else if (b->isSleeping && IsPhysicsBodyDynamic(a) && !a->isSleeping)
+            WakeUpPhysicsBody(b);
     }
 }
 
 // Wrapper to ensure PhysicsStep is run with at a fixed time step
-PHYSACDEF void RunPhysicsStep(void)
+PHYSACDEF void RunPhysicsStep(PhysicsWorld world)
 {
     // Calculate current time
-    currentTime = GetCurrentTime();
+    world->currentTime = GetCurrentTime();
 
     // Calculate current delta time
-    const double delta = currentTime - startTime;
+    const double delta = world->currentTime - world->startTime;
+
+    // Store the time elapsed since the last frame began, time spent with every body sleeping is not simulated
+    if (world->physicsIdle)
+        world->accumulator = 0.0;
+    else
+        world->accumulator += delta;
 
-    // Store the time elapsed since the last frame began
-    accumulator += delta;
+    unsigned int previousStepsCount = world->stepsCount;
+    int substeps = 0;
 
     // Fixed time stepping loop
-    while (accumulator >= deltaTime)
+    while (world->accumulator >= world->deltaTime)
     {
-        PhysicsStep();
-        accumulator -= deltaTime;
+        // Catching up after a long stall would only make the next call later, drop whole steps but keep the phase
+        if ((world->solverSettings.maxSubsteps > 0) && (substeps >= world->solverSettings.maxSubsteps))
+        {
+            world->accumulator = fmod(world->accumulator, world->deltaTime);
+            break;
+        }
+
+        // Bodies are created and destroyed between steps, a long catch up does not keep them waiting for all of it
+        LockPhysicsWorld(world);
+        PhysicsStep(world);
+        UnlockPhysicsWorld(world);
+
+        world->accumulator -= world->deltaTime;
+        substeps++;
     }
 
+    LockPhysicsWorld(world);
+
+    // Hand bodies transforms to the render thread once per call, not once per step
+    if ((world->stepsCount != previousStepsCount) || world->snapshotDirty)
+        PublishPhysicsSnapshot(world);
+
     // Record the starting of this frame
-    startTime = currentTime;
+    world->startTime = world->currentTime;
+    world->physicsIdle = (GetPhysicsAwakeBodiesCount(world) == 0);
+
+    UnlockPhysicsWorld(world);
 }
 
-PHYSACDEF void SetPhysicsTimeStep(double delta)
+PHYSACDEF void SetPhysicsTimeStep(PhysicsWorld world, double delta)
 {
-    deltaTime = delta;
+    world->deltaTime = delta;
 }
 
-// Finds a valid index for a new manifold initialization
-static int FindAvailableManifoldIndex()
+// Returns current solver settings, including the fixed time step
+PHYSACDEF PhysicsSolverSettings GetPhysicsSolverSettings(PhysicsWorld world)
 {
-    int index = -1;
-    for (int i = 0; i < PHYSAC_MAX_MANIFOLDS; i++)
-    {
-        int currentId = i;
+    PhysicsSolverSettings settings = world->solverSettings;
+    settings.timeStep = world->deltaTime;
 
-        // Check if current id already exist in other physics body
-        for (int k = 0; k < physicsManifoldsCount; k++)
-        {
-            if (contacts[k]->id == currentId)
-            {
-                currentId++;
-                break;
-            }
-        }
+    return settings;
+}
 
-        // If it is not used, use it as new physics body id
-        if (currentId == i)
-        {
-            index = i;
-            break;
-        }
+// Replaces solver settings, takes effect on next physics step
+PHYSACDEF void SetPhysicsSolverSettings(PhysicsWorld world, PhysicsSolverSettings settings)
+{
+    if ((settings.iterations < 1) || (settings.timeStep <= 0.0))
+    {
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] solver settings need at least one iteration and a positive time step\n");
+        #endif
+        return;
     }
 
-    return index;
+    world->solverSettings = settings;
+    world->deltaTime = settings.timeStep;
 }
 
-// Creates a new physics manifold to solve collision
+// Initializes the next free manifold of the manifolds arena to solve collision
 static PhysicsManifold CreatePhysicsManifold(PhysicsBody a, PhysicsBody b)
 {
-    PhysicsManifold newManifold = (PhysicsManifold)PHYSAC_MALLOC(sizeof(PhysicsManifoldData));
-    usedMemory += sizeof(PhysicsManifoldData);
-
-    int newId = FindAvailableManifoldIndex();
-    if (newId != -1)
-    {
-        // Initialize new manifold with generic values
-        newManifold->id = newId;
-        newManifold->bodyA = a;
-        newManifold->bodyB = b;
-        newManifold->penetration = 0;
-        newManifold->normal = PHYSAC_VECTOR_ZERO;
-        newManifold->contacts[0] = PHYSAC_VECTOR_ZERO;
-        newManifold->contacts[1] = PHYSAC_VECTOR_ZERO;
-        newManifold->contactsCount = 0;
-        newManifold->restitution = 0.0f;
-        newManifold->dynamicFriction = 0.0f;
-        newManifold->staticFriction = 0.0f;
+    PhysicsWorld world = a->world;
 
-        // Add new body to bodies pointers array and update bodies count
-        contacts[physicsManifoldsCount] = newManifold;
-        physicsManifoldsCount++;
+    if ((world->physicsManifoldsCount == world->manifoldsCapacity) && !GrowPhysicsManifolds(world))
+    {
+        // Bodies of a lost contact go through each other, counted so it does not go unnoticed
+        world->droppedManifoldsCount++;
+
+        #if defined(PHYSAC_DEBUG)
+            printf("[PHYSAC] new physics manifold creation failed because manifolds arena could not grow\n");
+        #endif
+        return NULL;
     }
-    #if defined(PHYSAC_DEBUG)
-        else
-            printf("[PHYSAC] new physics manifold creation failed because there is any available id to use\n");
-    #endif
+
+    // Initialize new manifold with generic values
+    PhysicsManifold newManifold = &world->manifolds[world->physicsManifoldsCount];
+    newManifold->id = world->physicsManifoldsCount;
+    newManifold->bodyA = a;
+    newManifold->bodyB = b;
+    newManifold->penetration = 0;
+    newManifold->normal = PHYSAC_VECTOR_ZERO;
+    newManifold->contacts[0] = PHYSAC_VECTOR_ZERO;
+    newManifold->contacts[1] = PHYSAC_VECTOR_ZERO;
+    newManifold->contactsCount = 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        newManifold->features[i] = 0;
+        newManifold->normalImpulses[i] = 0.0f;
+        newManifold->tangentImpulses[i] = 0.0f;
+    }
+
+    newManifold->restitution = 0.0f;
+    newManifold->dynamicFriction = 0.0f;
+    newManifold->staticFriction = 0.0f;
 
     return newManifold;
 }
 
-// Unitializes and destroys a physics manifold
-static void DestroyPhysicsManifold(PhysicsManifold manifold)
+// Returns the contact cache key of a manifold bodies pair
+static uint64_t GetPhysicsContactCacheKey(PhysicsManifold manifold)
 {
-    if (manifold != NULL)
+    return ((uint64_t)manifold->bodyA->id << 32) | manifold->bodyB->id;
+}
+
+// Carries over accumulated impulses of contacts that persisted since last step
+static void LoadPhysicsContactCache(PhysicsManifold manifold)
+{
+    PhysicsWorld world = manifold->bodyA->world;
+    uint64_t key = GetPhysicsContactCacheKey(manifold);
+    unsigned int slot = (unsigned int)(key*0x9E3779B97F4A7C15ull >> 32) & (world->contactCacheSlots - 1);
+
+    // Linear probing, a slot from another generation ends the chain
+    while (world->contactCache[slot].stamp == world->contactCacheStamp)
     {
-        int id = manifold->id;
-        int index = -1;
+        PhysicsContactCacheSlot *cached = &world->contactCache[slot];
 
-        for (int i = 0; i < physicsManifoldsCount; i++)
+        if (cached->key == key)
         {
-            if (contacts[i]->id == id)
+            for (int i = 0; i < manifold->contactsCount; i++)
             {
-                index = i;
-                break;
+                for (int j = 0; j < cached->contactsCount; j++)
+                {
+                    if (manifold->features[i] == cached->features[j])
+                    {
+                        manifold->normalImpulses[i] = cached->normalImpulses[j];
+                        manifold->tangentImpulses[i] = cached->tangentImpulses[j];
+                        break;
+                    }
+                }
             }
-        }
 
-        if (index == -1)
-        {
-            #if defined(PHYSAC_DEBUG)
-                printf("[PHYSAC] Not possible to manifold id %i in pointers array\n", id);
-            #endif
             return;
-        }      
+        }
+
+        slot = (slot + 1) & (world->contactCacheSlots - 1);
+    }
+}
+
+// Replaces the contact cache with accumulated impulses of current manifolds
+static void StorePhysicsContactCache(PhysicsWorld world)
+{
+    // A new generation empties every slot without clearing the table
+    world->contactCacheStamp++;
+
+    for (int i = 0; i < world->physicsManifoldsCount; i++)
+    {
+        PhysicsManifold manifold = &world->manifolds[i];
+        uint64_t key = GetPhysicsContactCacheKey(manifold);
+        unsigned int slot = (unsigned int)(key*0x9E3779B97F4A7C15ull >> 32) & (world->contactCacheSlots - 1);
+
+        while (world->contactCache[slot].stamp == world->contactCacheStamp)
+            slot = (slot + 1) & (world->contactCacheSlots - 1);
 
-        // Free manifold allocated memory
-        PHYSAC_FREE(manifold);
-        usedMemory -= sizeof(PhysicsManifoldData);
-        contacts[index] = NULL;
+        PhysicsContactCacheSlot *cached = &world->contactCache[slot];
+        cached->key = key;
+        cached->stamp = world->contactCacheStamp;
+        cached->contactsCount = manifold->contactsCount;
 
-        // Reorder physics manifolds pointers array and its catched index
-        for (int i = index; i < physicsManifoldsCount; i++)
+        for (int j = 0; j < manifold->contactsCount; j++)
         {
-            if ((i + 1) < physicsManifoldsCount)
-                contacts[i] = contacts[i + 1];
+            cached->features[j] = manifold->features[j];
+            cached->normalImpulses[j] = manifold->normalImpulses[j];
+            cached->tangentImpulses[j] = manifold->tangentImpulses[j];
         }
-
-        // Update physics manifolds count
-        physicsManifoldsCount--;
     }
-    #if defined(PHYSAC_DEBUG)
-        else
-            printf("[PHYSAC] error trying to destroy a null referenced manifold\n");
-    #endif
 }
 
 // Solves a created physics manifold between two physics bodies
@@ -1370,8 +2990,10 @@ static void SolveCircleToCircle(PhysicsManifold manifold)
     if ((bodyA == NULL) || (bodyB == NULL))
         return;
 
+    Vector2 positionA = GetPhysicsBodyPosition(bodyA);
+
     // Calculate translational vector, which is normal
-    Vector2 normal = Vector2Subtract(bodyB->position, bodyA->position);
+    Vector2 normal = Vector2Subtract(GetPhysicsBodyPosition(bodyB), positionA);
 
     float distSqr = MathLenSqr(normal);
     float radius = bodyA->shape.radius + bodyB->shape.radius;
@@ -1390,13 +3012,13 @@ static void SolveCircleToCircle(PhysicsManifold manifold)
     {
         manifold->penetration = bodyA->shape.radius;
         manifold->normal = (Vector2){ 1.0f, 0.0f };
-        manifold->contacts[0] = bodyA->position;
+        manifold->contacts[0] = positionA;
     }
     else
     {
         manifold->penetration = radius - distance;
         manifold->normal = (Vector2){ normal.x/distance, normal.y/distance }; // Faster than using MathNormalize() due to sqrt is already performed
-        manifold->contacts[0] = (Vector2){ manifold->normal.x*bodyA->shape.radius + bodyA->position.x, manifold->normal.y*bodyA->shape.radius + bodyA->position.y };
+        manifold->contacts[0] = (Vector2){ manifold->normal.x*bodyA->shape.radius + positionA.x, manifold->normal.y*bodyA->shape.radius + positionA.y };
     }
 
     // Update physics body grounded state if normal direction is down
@@ -1437,8 +3059,10 @@ static void SolveDifferentShapes(PhysicsManifold manifold, PhysicsBody bodyA, Ph
     manifold->contactsCount = 0;
 
     // Transform circle center to polygon transform space
-    Vector2 center = bodyA->position;
-    center = Mat2MultiplyVector2(Mat2Transpose(bodyB->shape.transform), Vector2Subtract(center, bodyB->position));
+    Vector2 positionA = GetPhysicsBodyPosition(bodyA);
+    Vector2 positionB = GetPhysicsBodyPosition(bodyB);
+    Vector2 center = positionA;
+    center = Mat2MultiplyVector2(Mat2Transpose(bodyB->shape.transform), Vector2Subtract(center, positionB));
 
     // Find edge with minimum penetration
     // It is the same concept as using support points in SolvePolygonToPolygon
@@ -1466,12 +3090,14 @@ static void SolveDifferentShapes(PhysicsManifold manifold, PhysicsBody bodyA, Ph
     Vector2 v2 = vertexData.positions[nextIndex];
 
     // Check to see if center is within polygon
+    manifold->features[0] = faceNormal << 2;
+
     if (separation < PHYSAC_EPSILON)
     {
         manifold->contactsCount = 1;
         Vector2 normal = Mat2MultiplyVector2(bodyB->shape.transform, vertexData.normals[faceNormal]);
         manifold->normal = (Vector2){ -normal.x, -normal.y };
-        manifold->contacts[0] = (Vector2){ manifold->normal.x*bodyA->shape.radius + bodyA->position.x, manifold->normal.y*bodyA->shape.radius + bodyA->position.y };
+        manifold->contacts[0] = (Vector2){ manifold->normal.x*bodyA->shape.radius + positionA.x, manifold->normal.y*bodyA->shape.radius + positionA.y };
         manifold->penetration = bodyA->shape.radius;
         return;
     }
@@ -1487,12 +3113,13 @@ static void SolveDifferentShapes(PhysicsManifold manifold, PhysicsBody bodyA, Ph
             return;
 
         manifold->contactsCount = 1;
+        manifold->features[0] |= 1;
         Vector2 normal = Vector2Subtract(v1, center);
         normal = Mat2MultiplyVector2(bodyB->shape.transform, normal);
         MathNormalize(&normal);
         manifold->normal = normal;
         v1 = Mat2MultiplyVector2(bodyB->shape.transform, v1);
-        v1 = Vector2Add(v1, bodyB->position);
+        v1 = Vector2Add(v1, positionB);
         manifold->contacts[0] = v1;
     }
     else if (dot2 <= 0.0f) // Closest to v2
@@ -1501,9 +3128,10 @@ static void SolveDifferentShapes(PhysicsManifold manifold, PhysicsBody bodyA, Ph
             return;
 
         manifold->contactsCount = 1;
+        manifold->features[0] |= 2;
         Vector2 normal = Vector2Subtract(v2, center);
         v2 = Mat2MultiplyVector2(bodyB->shape.transform, v2);
-        v2 = Vector2Add(v2, bodyB->position);
+        v2 = Vector2Add(v2, positionB);
         manifold->contacts[0] = v2;
         normal = Mat2MultiplyVector2(bodyB->shape.transform, normal);
         MathNormalize(&normal);
@@ -1518,7 +3146,7 @@ static void SolveDifferentShapes(PhysicsManifold manifold, PhysicsBody bodyA, Ph
 
         normal = Mat2MultiplyVector2(bodyB->shape.transform, normal);
         manifold->normal = (Vector2){ -normal.x, -normal.y };
-        manifold->contacts[0] = (Vector2){ manifold->normal.x*bodyA->shape.radius + bodyA->position.x, manifold->normal.y*bodyA->shape.radius + bodyA->position.y };
+        manifold->contacts[0] = (Vector2){ manifold->normal.x*bodyA->shape.radius + positionA.x, manifold->normal.y*bodyA->shape.radius + positionA.y };
         manifold->contactsCount = 1;
     }
 }
@@ -1570,7 +3198,10 @@ static void SolvePolygonToPolygon(PhysicsManifold manifold)
 
     // World space incident face
     Vector2 incidentFace[2];
-    FindIncidentFace(&incidentFace[0], &incidentFace[1], refPoly, incPoly, referenceIndex);
+    int incidentIndex = FindIncidentFace(&incidentFace[0], &incidentFace[1], refPoly, incPoly, referenceIndex);
+
+    // Contacts are identified by both faces and the incident face end they were clipped from
+    unsigned int feature = ((flip ? 1 : 0) << 16) | (referenceIndex << 8) | (incidentIndex << 1);
 
     // Setup reference face vertices
     PolygonData refData = refPoly.vertexData;
@@ -1580,9 +3211,9 @@ static void SolvePolygonToPolygon(PhysicsManifold manifold)
 
     // Transform vertices to world space
     v1 = Mat2MultiplyVector2(refPoly.transform, v1);
-    v1 = Vector2Add(v1, refPoly.body->position);
+    v1 = Vector2Add(v1, GetPhysicsBodyPosition(refPoly.body));
     v2 = Mat2MultiplyVector2(refPoly.transform, v2);
-    v2 = Vector2Add(v2, refPoly.body->position);
+    v2 = Vector2Add(v2, GetPhysicsBodyPosition(refPoly.body));
 
     // Calculate reference face side normal in world space
     Vector2 sidePlaneNormal = Vector2Subtract(v2, v1);
@@ -1611,6 +3242,7 @@ static void SolvePolygonToPolygon(PhysicsManifold manifold)
     if (separation <= 0.0f)
     {
         manifold->contacts[currentPoint] = incidentFace[0];
+        manifold->features[currentPoint] = feature;
         manifold->penetration = -separation;
         currentPoint++;
     }
@@ -1622,6 +3254,7 @@ static void SolvePolygonToPolygon(PhysicsManifold manifold)
     if (separation <= 0.0f)
     {
         manifold->contacts[currentPoint] = incidentFace[1];
+        manifold->features[currentPoint] = feature | 1;
         manifold->penetration += -separation;
         currentPoint++;
 
@@ -1633,22 +3266,43 @@ static void SolvePolygonToPolygon(PhysicsManifold manifold)
 }
 
 // Integrates physics forces into velocity
-static void IntegratePhysicsForces(PhysicsBody body)
+static void IntegratePhysicsForces(PhysicsWorld world)
 {
-    if ((body == NULL) || (body->inverseMass == 0.0f) || !body->enabled)
-        return;
-
-    body->velocity.x += (body->force.x*body->inverseMass)*(deltaTime/2.0);
-    body->velocity.y += (body->force.y*body->inverseMass)*(deltaTime/2.0);
+    PhysicsBodiesState *state = &world->bodiesState;
+    const float forceStep = world->deltaTime/2.0;
+    const float gravityStepX = world->gravityForce.x*(world->deltaTime/1000/2.0);
+    const float gravityStepY = world->gravityForce.y*(world->deltaTime/1000/2.0);
+    int i = 0;
+
+    #if defined(PHYSAC_SIMD_WIDTH)
+        const PhysacFloats packedForceStep = SimdSet(forceStep);
+        const PhysacFloats packedGravityStepX = SimdSet(gravityStepX);
+        const PhysacFloats packedGravityStepY = SimdSet(gravityStepY);
+
+        for (; (i + PHYSAC_SIMD_WIDTH) <= world->physicsBodiesCount; i += PHYSAC_SIMD_WIDTH)
+        {
+            PhysacFloats dynamicMask = SimdLoad(&state->dynamicMask[i]);
+            PhysacFloats gravityMask = SimdLoad(&state->gravityMask[i]);
+            PhysacFloats linearStep = SimdMul(SimdLoad(&state->inverseMass[i]), packedForceStep);
+            PhysacFloats angularStep = SimdMul(SimdLoad(&state->inverseInertia[i]), packedForceStep);
+
+            PhysacFloats deltaX = SimdAdd(SimdMul(SimdLoad(&state->forceX[i]), linearStep), SimdMul(gravityMask, packedGravityStepX));
+            PhysacFloats deltaY = SimdAdd(SimdMul(SimdLoad(&state->forceY[i]), linearStep), SimdMul(gravityMask, packedGravityStepY));
+            PhysacFloats deltaAngular = SimdMul(SimdMul(SimdLoad(&state->torque[i]), angularStep), SimdLoad(&state->rotationMask[i]));
+
+            SimdStore(&state->velocityX[i], SimdAdd(SimdLoad(&state->velocityX[i]), SimdMul(deltaX, dynamicMask)));
+            SimdStore(&state->velocityY[i], SimdAdd(SimdLoad(&state->velocityY[i]), SimdMul(deltaY, dynamicMask)));
+            SimdStore(&state->angularVelocity[i], SimdAdd(SimdLoad(&state->angularVelocity[i]), SimdMul(deltaAngular, dynamicMask)));
+        }
+    #endif
 
-    if (body->useGravity)
+    // Scalar fallback, also used for the bodies left over from the packed loop
+    for (; i < world->physicsBodiesCount; i++)
     {
-        body->velocity.x += gravityForce.x*(deltaTime/1000/2.0);
-        body->velocity.y += gravityForce.y*(deltaTime/1000/2.0);
+        state->velocityX[i] += (state->forceX[i]*state->inverseMass[i]*forceStep + state->gravityMask[i]*gravityStepX)*state->dynamicMask[i];
+        state->velocityY[i] += (state->forceY[i]*state->inverseMass[i]*forceStep + state->gravityMask[i]*gravityStepY)*state->dynamicMask[i];
+        state->angularVelocity[i] += state->torque[i]*state->inverseInertia[i]*forceStep*state->rotationMask[i]*state->dynamicMask[i];
     }
-
-    if (!body->freezeOrient)
-        body->angularVelocity += body->torque*body->inverseInertia*(deltaTime/2.0);
 }
 
 // Initializes physics manifolds to solve collisions
@@ -1660,158 +3314,196 @@ static void InitializePhysicsManifolds(PhysicsManifold manifold)
     if ((bodyA == NULL) || (bodyB == NULL))
         return;
 
+    PhysicsWorld world = bodyA->world;
+
     // Calculate average restitution, static and dynamic friction
     manifold->restitution = sqrtf(bodyA->restitution*bodyB->restitution);
     manifold->staticFriction = sqrtf(bodyA->staticFriction*bodyB->staticFriction);
     manifold->dynamicFriction = sqrtf(bodyA->dynamicFriction*bodyB->dynamicFriction);
 
+    float inverseMassA = world->bodiesState.inverseMass[bodyA->index];
+    float inverseMassB = world->bodiesState.inverseMass[bodyB->index];
+    float inverseInertiaA = world->bodiesState.inverseInertia[bodyA->index];
+    float inverseInertiaB = world->bodiesState.inverseInertia[bodyB->index];
+    Vector2 positionA = GetPhysicsBodyPosition(bodyA);
+    Vector2 positionB = GetPhysicsBodyPosition(bodyB);
+    Vector2 tangent = { manifold->normal.y, -manifold->normal.x };
+
     for (int i = 0; i < manifold->contactsCount; i++)
     {
         // Caculate radius from center of mass to contact
-        Vector2 radiusA = Vector2Subtract(manifold->contacts[i], bodyA->position);
-        Vector2 radiusB = Vector2Subtract(manifold->contacts[i], bodyB->position);
+        Vector2 radiusA = Vector2Subtract(manifold->contacts[i], positionA);
+        Vector2 radiusB = Vector2Subtract(manifold->contacts[i], positionB);
 
-        Vector2 crossA = MathCross(bodyA->angularVelocity, radiusA);
-        Vector2 crossB = MathCross(bodyB->angularVelocity, radiusB);
-
-        Vector2 radiusV = { 0.0f, 0.0f };
-        radiusV.x = bodyB->velocity.x + crossB.x - bodyA->velocity.x - crossA.x;
-        radiusV.y = bodyB->velocity.y + crossB.y - bodyA->velocity.y - crossA.y;
+        Vector2 radiusV = GetContactRelativeVelocity(bodyA, bodyB, radiusA, radiusB);
 
         // Determine if we should perform a resting collision or not;
         // The idea is if the only thing moving this object is gravity, then the collision should be performed without any restitution
-        if (MathLenSqr(radiusV) < (MathLenSqr((Vector2){ gravityForce.x*deltaTime/1000, gravityForce.y*deltaTime/1000 }) + PHYSAC_EPSILON))
+        if (MathLenSqr(radiusV) < (MathLenSqr((Vector2){ world->gravityForce.x*world->deltaTime/1000, world->gravityForce.y*world->deltaTime/1000 }) + PHYSAC_EPSILON))
             manifold->restitution = 0;
+
+        // Effective masses only depend on contact geometry, compute them once for every iteration
+        float raCrossN = MathCrossVector2(radiusA, manifold->normal);
+        float rbCrossN = MathCrossVector2(radiusB, manifold->normal);
+        float inverseMassSum = inverseMassA + inverseMassB + (raCrossN*raCrossN)*inverseInertiaA + (rbCrossN*rbCrossN)*inverseInertiaB;
+        manifold->normalMasses[i] = ((inverseMassSum > 0.0f) ? 1.0f/inverseMassSum : 0.0f);
+
+        float raCrossT = MathCrossVector2(radiusA, tangent);
+        float rbCrossT = MathCrossVector2(radiusB, tangent);
+        float inverseTangentMassSum = inverseMassA + inverseMassB + (raCrossT*raCrossT)*inverseInertiaA + (rbCrossT*rbCrossT)*inverseInertiaB;
+        manifold->tangentMasses[i] = ((inverseTangentMassSum > 0.0f) ? 1.0f/inverseTangentMassSum : 0.0f);
+
+        manifold->velocityBiases[i] = 0.0f;
+    }
+
+    for (int i = 0; i < manifold->contactsCount; i++)
+    {
+        Vector2 radiusA = Vector2Subtract(manifold->contacts[i], positionA);
+        Vector2 radiusB = Vector2Subtract(manifold->contacts[i], positionB);
+
+        // Bounce back at restitution times the approach velocity, once restitution is known for the whole manifold
+        float contactVelocity = MathDot(GetContactRelativeVelocity(bodyA, bodyB, radiusA, radiusB), manifold->normal);
+
+        if (contactVelocity < 0.0f)
+            manifold->velocityBiases[i] = -manifold->restitution*contactVelocity;
+
+        // Warm start, apply the impulses this contact ended the last step with
+        Vector2 impulse = {
+            manifold->normal.x*manifold->normalImpulses[i] + tangent.x*manifold->tangentImpulses[i],
+            manifold->normal.y*manifold->normalImpulses[i] + tangent.y*manifold->tangentImpulses[i]
+        };
+
+        ApplyPhysicsImpulse(bodyA, (Vector2){ -impulse.x, -impulse.y }, radiusA);
+        ApplyPhysicsImpulse(bodyB, impulse, radiusB);
     }
 }
 
-// Integrates physics collisions impulses to solve collisions
-static void IntegratePhysicsImpulses(PhysicsManifold manifold)
+// Integrates physics collisions impulses to solve collisions, returns the largest contact velocity change
+static float IntegratePhysicsImpulses(PhysicsManifold manifold)
 {
     PhysicsBody bodyA = manifold->bodyA;
     PhysicsBody bodyB = manifold->bodyB;
+    float residual = 0.0f;
 
     if ((bodyA == NULL) || (bodyB == NULL))
-        return;
+        return residual;
 
     // Early out and positional correct if both objects have infinite mass
-    if (fabs(bodyA->inverseMass + bodyB->inverseMass) <= PHYSAC_EPSILON)
+    PhysicsBodiesState *state = &bodyA->world->bodiesState;
+
+    // NOTE: Velocities are zeroed in place, the public setter would wake bodies up every iteration and static bodies are never written
+    if (fabs(state->inverseMass[bodyA->index] + state->inverseMass[bodyB->index]) <= PHYSAC_EPSILON)
     {
-        bodyA->velocity = PHYSAC_VECTOR_ZERO;
-        bodyB->velocity = PHYSAC_VECTOR_ZERO;
-        return;
+        if (IsPhysicsBodyDynamic(bodyA))
+        {
+            state->velocityX[bodyA->index] = 0.0f;
+            state->velocityY[bodyA->index] = 0.0f;
+        }
+
+        if (IsPhysicsBodyDynamic(bodyB))
+        {
+            state->velocityX[bodyB->index] = 0.0f;
+            state->velocityY[bodyB->index] = 0.0f;
+        }
+
+        return residual;
     }
 
+    Vector2 positionA = GetPhysicsBodyPosition(bodyA);
+    Vector2 positionB = GetPhysicsBodyPosition(bodyB);
+    Vector2 tangent = { manifold->normal.y, -manifold->normal.x };
+
     for (int i = 0; i < manifold->contactsCount; i++)
     {
         // Calculate radius from center of mass to contact
-        Vector2 radiusA = Vector2Subtract(manifold->contacts[i], bodyA->position);
-        Vector2 radiusB = Vector2Subtract(manifold->contacts[i], bodyB->position);
-
-        // Calculate relative velocity
-        Vector2 radiusV = { 0.0f, 0.0f };
-        radiusV.x = bodyB->velocity.x + MathCross(bodyB->angularVelocity, radiusB).x - bodyA->velocity.x - MathCross(bodyA->angularVelocity, radiusA).x;
-        radiusV.y = bodyB->velocity.y + MathCross(bodyB->angularVelocity, radiusB).y - bodyA->velocity.y - MathCross(bodyA->angularVelocity, radiusA).y;
+        Vector2 radiusA = Vector2Subtract(manifold->contacts[i], positionA);
+        Vector2 radiusB = Vector2Subtract(manifold->contacts[i], positionB);
 
         // Relative velocity along the normal
+        Vector2 radiusV = GetContactRelativeVelocity(bodyA, bodyB, radiusA, radiusB);
         float contactVelocity = MathDot(radiusV, manifold->normal);
 
-        // Do not resolve if velocities are separating
-        if (contactVelocity > 0.0f)
-            return;
-
-        float raCrossN = MathCrossVector2(radiusA, manifold->normal);
-        float rbCrossN = MathCrossVector2(radiusB, manifold->normal);
-
-        float inverseMassSum = bodyA->inverseMass + bodyB->inverseMass + (raCrossN*raCrossN)*bodyA->inverseInertia + (rbCrossN*rbCrossN)*bodyB->inverseInertia;
+        // Clamp the accumulated impulse rather than this iteration one, so later iterations can take back what earlier ones overshot
+        float impulse = manifold->normalMasses[i]*(manifold->velocityBiases[i] - contactVelocity);
+        float previousImpulse = manifold->normalImpulses[i];
+        manifold->normalImpulses[i] = max(previousImpulse + impulse, 0.0f);
+        impulse = manifold->normalImpulses[i] - previousImpulse;
 
-        // Calculate impulse scalar value
-        float impulse = -(1.0f + manifold->restitution)*contactVelocity;
-        impulse /= inverseMassSum;
-        impulse /= (float)manifold->contactsCount;
+        // Velocity change is the impulse over the effective mass
+        if (manifold->normalMasses[i] > 0.0f)
+            residual = max(residual, fabsf(impulse)/manifold->normalMasses[i]);
 
-        // Apply impulse to each physics body
         Vector2 impulseV = { manifold->normal.x*impulse, manifold->normal.y*impulse };
+        ApplyPhysicsImpulse(bodyA, (Vector2){ -impulseV.x, -impulseV.y }, radiusA);
+        ApplyPhysicsImpulse(bodyB, impulseV, radiusB);
 
-        if (bodyA->enabled)
-        {
-            bodyA->velocity.x += bodyA->inverseMass*(-impulseV.x);
-            bodyA->velocity.y += bodyA->inverseMass*(-impulseV.y);
-            
-            if (!bodyA->freezeOrient)
-                bodyA->angularVelocity += bodyA->inverseInertia*MathCrossVector2(radiusA, (Vector2){ -impulseV.x, -impulseV.y });
-        }
+        // Relative velocity along the tangent after the normal impulse
+        radiusV = GetContactRelativeVelocity(bodyA, bodyB, radiusA, radiusB);
+        float impulseTangent = -manifold->tangentMasses[i]*MathDot(radiusV, tangent);
 
-        if (bodyB->enabled)
+        // Apply coulumb's law, contacts stick under static friction and slide with dynamic friction
+        float previousTangent = manifold->tangentImpulses[i];
+        float tangentImpulse = previousTangent + impulseTangent;
+        float staticLimit = manifold->normalImpulses[i]*manifold->staticFriction;
+
+        if (fabs(tangentImpulse) > staticLimit)
         {
-            bodyB->velocity.x += bodyB->inverseMass*(impulseV.x);
-            bodyB->velocity.y += bodyB->inverseMass*(impulseV.y);
-            
-            if (!bodyB->freezeOrient)
-                bodyB->angularVelocity += bodyB->inverseInertia*MathCrossVector2(radiusB, impulseV);
+            float dynamicLimit = manifold->normalImpulses[i]*manifold->dynamicFriction;
+            tangentImpulse = ((tangentImpulse > 0.0f) ? dynamicLimit : -dynamicLimit);
         }
 
-        // Apply friction impulse to each physics body
-        radiusV.x = bodyB->velocity.x + MathCross(bodyB->angularVelocity, radiusB).x - bodyA->velocity.x - MathCross(bodyA->angularVelocity, radiusA).x;
-        radiusV.y = bodyB->velocity.y + MathCross(bodyB->angularVelocity, radiusB).y - bodyA->velocity.y - MathCross(bodyA->angularVelocity, radiusA).y;
+        manifold->tangentImpulses[i] = tangentImpulse;
+        impulseTangent = tangentImpulse - previousTangent;
 
-        Vector2 tangent = { radiusV.x - (manifold->normal.x*MathDot(radiusV, manifold->normal)), radiusV.y - (manifold->normal.y*MathDot(radiusV, manifold->normal)) };
-        MathNormalize(&tangent);
+        if (manifold->tangentMasses[i] > 0.0f)
+            residual = max(residual, fabsf(impulseTangent)/manifold->tangentMasses[i]);
 
-        // Calculate impulse tangent magnitude
-        float impulseTangent = -MathDot(radiusV, tangent);
-        impulseTangent /= inverseMassSum;
-        impulseTangent /= (float)manifold->contactsCount;
+        // Apply friction impulse
+        Vector2 tangentImpulseV = { tangent.x*impulseTangent, tangent.y*impulseTangent };
+        ApplyPhysicsImpulse(bodyA, (Vector2){ -tangentImpulseV.x, -tangentImpulseV.y }, radiusA);
+        ApplyPhysicsImpulse(bodyB, tangentImpulseV, radiusB);
+    }
 
-        float absImpulseTangent = fabs(impulseTangent);
+    return residual;
+}
 
-        // Don't apply tiny friction impulses
-        if (absImpulseTangent <= PHYSAC_EPSILON)
-            return;
+// Integrates physics velocity into position and forces
+static void IntegratePhysicsVelocity(PhysicsWorld world)
+{
+    PhysicsBodiesState *state = &world->bodiesState;
+    const float step = world->deltaTime;
+    int i = 0;
 
-        // Apply coulumb's law
-        Vector2 tangentImpulse = { 0.0f, 0.0f };
-        if (absImpulseTangent < impulse*manifold->staticFriction)
-            tangentImpulse = (Vector2){ tangent.x*impulseTangent, tangent.y*impulseTangent };
-        else
-            tangentImpulse = (Vector2){ tangent.x*-impulse*manifold->dynamicFriction, tangent.y*-impulse*manifold->dynamicFriction };
+    #if defined(PHYSAC_SIMD_WIDTH)
+        const PhysacFloats packedStep = SimdSet(step);
 
-        // Apply friction impulse
-        if (bodyA->enabled)
+        for (; (i + PHYSAC_SIMD_WIDTH) <= world->physicsBodiesCount; i += PHYSAC_SIMD_WIDTH)
         {
-            bodyA->velocity.x += bodyA->inverseMass*(-tangentImpulse.x);
-            bodyA->velocity.y += bodyA->inverseMass*(-tangentImpulse.y);
+            PhysacFloats enabledStep = SimdMul(SimdLoad(&state->enabledMask[i]), packedStep);
+            PhysacFloats angularStep = SimdMul(SimdLoad(&state->rotationMask[i]), enabledStep);
 
-            if (!bodyA->freezeOrient)
-                bodyA->angularVelocity += bodyA->inverseInertia*MathCrossVector2(radiusA, (Vector2){ -tangentImpulse.x, -tangentImpulse.y });
+            SimdStore(&state->positionX[i], SimdAdd(SimdLoad(&state->positionX[i]), SimdMul(SimdLoad(&state->velocityX[i]), enabledStep)));
+            SimdStore(&state->positionY[i], SimdAdd(SimdLoad(&state->positionY[i]), SimdMul(SimdLoad(&state->velocityY[i]), enabledStep)));
+            SimdStore(&state->orient[i], SimdAdd(SimdLoad(&state->orient[i]), SimdMul(SimdLoad(&state->angularVelocity[i]), angularStep)));
         }
+    #endif
 
-        if (bodyB->enabled)
-        {
-            bodyB->velocity.x += bodyB->inverseMass*(tangentImpulse.x);
-            bodyB->velocity.y += bodyB->inverseMass*(tangentImpulse.y);
-
-            if (!bodyB->freezeOrient)
-                bodyB->angularVelocity += bodyB->inverseInertia*MathCrossVector2(radiusB, tangentImpulse);
-        }
+    // Scalar fallback, also used for the bodies left over from the packed loop
+    for (; i < world->physicsBodiesCount; i++)
+    {
+        state->positionX[i] += state->velocityX[i]*step*state->enabledMask[i];
+        state->positionY[i] += state->velocityY[i]*step*state->enabledMask[i];
+        state->orient[i] += state->angularVelocity[i]*step*state->rotationMask[i]*state->enabledMask[i];
     }
-}
-
-// Integrates physics velocity into position and forces
-static void IntegratePhysicsVelocity(PhysicsBody body)
-{
-    if ((body == NULL) ||!body->enabled)
-        return;
-
-    body->position.x += body->velocity.x*deltaTime;
-    body->position.y += body->velocity.y*deltaTime;
-
-    if (!body->freezeOrient)
-        body->orient += body->angularVelocity*deltaTime;
 
-    Mat2Set(&body->shape.transform, body->orient);
+    // Update shapes transform with the new rotations
+    for (i = 0; i < world->physicsBodiesCount; i++)
+    {
+        if (world->bodies[i]->enabled)
+            Mat2Set(&world->bodies[i]->shape.transform, state->orient[i]);
+    }
 
-    IntegratePhysicsForces(body);
+    IntegratePhysicsForces(world);
 }
 
 // Corrects physics bodies positions based on manifolds collision information
@@ -1823,23 +3515,64 @@ static void CorrectPhysicsPositions(PhysicsManifold manifold)
     if ((bodyA == NULL) || (bodyB == NULL))
         return;
 
+    PhysicsWorld world = bodyA->world;
+    PhysicsBodiesState *state = &world->bodiesState;
+    const PhysicsSolverSettings *settings = &world->solverSettings;
+
+    unsigned int a = bodyA->index;
+    unsigned int b = bodyB->index;
+
     Vector2 correction = { 0.0f, 0.0f };
-    correction.x = (max(manifold->penetration - PHYSAC_PENETRATION_ALLOWANCE, 0.0f)/(bodyA->inverseMass + bodyB->inverseMass))*manifold->normal.x*PHYSAC_PENETRATION_CORRECTION;
-    correction.y = (max(manifold->penetration - PHYSAC_PENETRATION_ALLOWANCE, 0.0f)/(bodyA->inverseMass + bodyB->inverseMass))*manifold->normal.y*PHYSAC_PENETRATION_CORRECTION;
+    correction.x = (max(manifold->penetration - settings->penetrationAllowance, 0.0f)/(state->inverseMass[a] + state->inverseMass[b]))*manifold->normal.x*settings->penetrationCorrection;
+    correction.y = (max(manifold->penetration - settings->penetrationAllowance, 0.0f)/(state->inverseMass[a] + state->inverseMass[b]))*manifold->normal.y*settings->penetrationCorrection;
 
     if (bodyA->enabled)
     {
-        bodyA->position.x -= correction.x*bodyA->inverseMass;
-        bodyA->position.y -= correction.y*bodyA->inverseMass;
+        state->positionX[a] -= correction.x*state->inverseMass[a];
+        state->positionY[a] -= correction.y*state->inverseMass[a];
     }
 
     if (bodyB->enabled)
     {
-        bodyB->position.x += correction.x*bodyB->inverseMass;
-        bodyB->position.y += correction.y*bodyB->inverseMass;
+        state->positionX[b] += correction.x*state->inverseMass[b];
+        state->positionY[b] += correction.y*state->inverseMass[b];
     }
 }
 
+// Returns relative velocity of body B with respect to body A at a contact point
+static Vector2 GetContactRelativeVelocity(PhysicsBody bodyA, PhysicsBody bodyB, Vector2 radiusA, Vector2 radiusB)
+{
+    unsigned int a = bodyA->index;
+    unsigned int b = bodyB->index;
+    PhysicsBodiesState *state = &bodyA->world->bodiesState;
+
+    Vector2 crossA = MathCross(state->angularVelocity[a], radiusA);
+    Vector2 crossB = MathCross(state->angularVelocity[b], radiusB);
+
+    Vector2 radiusV = { 0.0f, 0.0f };
+    radiusV.x = state->velocityX[b] + crossB.x - state->velocityX[a] - crossA.x;
+    radiusV.y = state->velocityY[b] + crossB.y - state->velocityY[a] - crossA.y;
+
+    return radiusV;
+}
+
+// Applies an impulse at a contact vector relative to body center of mass
+static void ApplyPhysicsImpulse(PhysicsBody body, Vector2 impulse, Vector2 contactVector)
+{
+    // Static bodies are shared by islands solved in parallel, they must not be written even with a zero impulse
+    if (!IsPhysicsBodyDynamic(body))
+        return;
+
+    unsigned int index = body->index;
+    PhysicsBodiesState *state = &body->world->bodiesState;
+
+    state->velocityX[index] += state->inverseMass[index]*impulse.x;
+    state->velocityY[index] += state->inverseMass[index]*impulse.y;
+
+    if (!body->freezeOrient)
+        state->angularVelocity[index] += state->inverseInertia[index]*MathCrossVector2(contactVector, impulse);
+}
+
 // Returns the extreme point along a direction within a polygon
 static Vector2 GetSupport(PhysicsShape shape, Vector2 dir)
 {
@@ -1868,6 +3601,9 @@ static float FindAxisLeastPenetration(int *faceIndex, PhysicsShape shapeA, Physi
     float bestDistance = -PHYSAC_FLT_MAX;
     int bestIndex = 0;
 
+    Vector2 positionA = GetPhysicsBodyPosition(shapeA.body);
+    Vector2 positionB = GetPhysicsBodyPosition(shapeB.body);
+
     PolygonData dataA = shapeA.vertexData;
 
     for (int i = 0; i < dataA.vertexCount; i++)
@@ -1886,8 +3622,8 @@ static float FindAxisLeastPenetration(int *faceIndex, PhysicsShape shapeA, Physi
         // Retrieve vertex on face from A shape, transform into B shape's model space
         Vector2 vertex = dataA.positions[i];
         vertex = Mat2MultiplyVector2(shapeA.transform, vertex);
-        vertex = Vector2Add(vertex, shapeA.body->position);
-        vertex = Vector2Subtract(vertex, shapeB.body->position);
+        vertex = Vector2Add(vertex, positionA);
+        vertex = Vector2Subtract(vertex, positionB);
         vertex = Mat2MultiplyVector2(buT, vertex);
 
         // Compute penetration distance in B shape's model space
@@ -1906,7 +3642,7 @@ static float FindAxisLeastPenetration(int *faceIndex, PhysicsShape shapeA, Physi
 }
 
 // Finds two polygon shapes incident face
-static void FindIncidentFace(Vector2 *v0, Vector2 *v1, PhysicsShape ref, PhysicsShape inc, int index)
+static int FindIncidentFace(Vector2 *v0, Vector2 *v1, PhysicsShape ref, PhysicsShape inc, int index)
 {
     PolygonData refData = ref.vertexData;
     PolygonData incData = inc.vertexData;
@@ -1933,11 +3669,14 @@ static void FindIncidentFace(Vector2 *v0, Vector2 *v1, PhysicsShape ref, Physics
     }
 
     // Assign face vertices for incident face
+    Vector2 incPosition = GetPhysicsBodyPosition(inc.body);
     *v0 = Mat2MultiplyVector2(inc.transform, incData.positions[incidentFace]);
-    *v0 = Vector2Add(*v0, inc.body->position);
-    incidentFace = (((incidentFace + 1) < incData.vertexCount) ? (incidentFace + 1) : 0);
-    *v1 = Mat2MultiplyVector2(inc.transform, incData.positions[incidentFace]);
-    *v1 = Vector2Add(*v1, inc.body->position);
+    *v0 = Vector2Add(*v0, incPosition);
+    int nextIndex = (((incidentFace + 1) < incData.vertexCount) ? (incidentFace + 1) : 0);
+    *v1 = Mat2MultiplyVector2(inc.transform, incData.positions[nextIndex]);
+    *v1 = Vector2Add(*v1, incPosition);
+
+    return incidentFace;
 }
 
 // Calculates clipping based on a normal and two faces
@@ -2020,7 +3759,6 @@ static void InitTimer(void)
     #endif
 
     baseTime = GetTimeCount();      // Get MONOTONIC clock time offset
-    startTime = GetCurrentTime();   // Get current time
 }
 
 // Get hi-res MONOTONIC time measure in seconds
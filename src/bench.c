@@ -0,0 +1,219 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <wayland-client.h>
+#include "xdg-shell-client-protocol.h"
+#include "bench.h"
+
+#define log(...) fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n")
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+// glibc entry points behind malloc, calls are counted here before being forwarded
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+// Per thread, so the client thread does not show up in the compositor numbers
+static _Thread_local uint64_t allocations;
+
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+uint64_t bench_allocations(void) {
+    return allocations;
+}
+#else
+uint64_t bench_allocations(void) {
+    return 0;
+}
+#endif
+
+typedef struct window {
+    struct wl_surface *surface;
+    struct xdg_surface *xdg_surface;
+    struct xdg_toplevel *xdg_toplevel;
+    struct wl_buffer *buffer;
+    int width, height;
+    bool attached;
+} Window;
+
+typedef struct client {
+    pthread_t thread;
+    int fd;
+
+    struct wl_display *display;
+    struct wl_compositor *compositor;
+    struct wl_shm *shm;
+    struct xdg_wm_base *wm_base;
+
+    Window *windows;
+    int windows_count;
+} Client;
+
+static Client client;
+
+static void wm_base_ping(void *data, struct xdg_wm_base *wm_base, uint32_t serial) {
+    xdg_wm_base_pong(wm_base, serial);
+}
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+    .ping = wm_base_ping,
+};
+
+static void registry_global(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        client.compositor = wl_registry_bind(registry, name, &wl_compositor_interface, 4);
+    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+        client.shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        client.wm_base = wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener(client.wm_base, &wm_base_listener, NULL);
+    }
+}
+
+static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t name) {
+}
+
+static const struct wl_registry_listener registry_listener = {
+    .global = registry_global,
+    .global_remove = registry_global_remove,
+};
+
+// Opaque buffer filled with one color, windows never redraw so a single buffer is enough
+static struct wl_buffer *create_buffer(int width, int height, uint32_t color) {
+    int stride = width * 4;
+    int size = stride * height;
+
+    int fd = memfd_create("bench-buffer", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+
+    uint32_t *pixels = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pixels == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    for (int i = 0; i < width * height; i++) pixels[i] = color;
+    munmap(pixels, size);
+
+    struct wl_shm_pool *pool = wl_shm_create_pool(client.shm, fd, size);
+    struct wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0, width, height, stride, WL_SHM_FORMAT_XRGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+    return buffer;
+}
+
+static void xdg_surface_configure(void *data, struct xdg_surface *xdg_surface, uint32_t serial) {
+    Window *window = data;
+    xdg_surface_ack_configure(xdg_surface, serial);
+
+    // The first configure maps the window, later ones are acknowledged with the same buffer
+    if (!window->attached) {
+        wl_surface_attach(window->surface, window->buffer, 0, 0);
+        wl_surface_damage_buffer(window->surface, 0, 0, window->width, window->height);
+        window->attached = true;
+    }
+    wl_surface_commit(window->surface);
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+    .configure = xdg_surface_configure,
+};
+
+static void window_init(Window *window, int index) {
+    // Sizes and colors only depend on the index, so runs are comparable
+    window->width = 160 + (index * 37) % 160;
+    window->height = 120 + (index * 53) % 120;
+    window->attached = false;
+
+    uint32_t color = 0xff000000 | ((index * 0x3f1d5b) & 0xffffff);
+    window->buffer = create_buffer(window->width, window->height, color);
+
+    window->surface = wl_compositor_create_surface(client.compositor);
+    window->xdg_surface = xdg_wm_base_get_xdg_surface(client.wm_base, window->surface);
+    xdg_surface_add_listener(window->xdg_surface, &xdg_surface_listener, window);
+    window->xdg_toplevel = xdg_surface_get_toplevel(window->xdg_surface);
+    xdg_toplevel_set_title(window->xdg_toplevel, "bench");
+    wl_surface_commit(window->surface);
+}
+
+static void window_finish(Window *window) {
+    xdg_toplevel_destroy(window->xdg_toplevel);
+    xdg_surface_destroy(window->xdg_surface);
+    wl_surface_destroy(window->surface);
+    if (window->buffer != NULL) wl_buffer_destroy(window->buffer);
+}
+
+static void *client_run(void *data) {
+    client.display = wl_display_connect_to_fd(client.fd);
+    if (client.display == NULL) {
+        log("Fail to connect bench client");
+        close(client.fd);
+        return NULL;
+    }
+
+    struct wl_registry *registry = wl_display_get_registry(client.display);
+    wl_registry_add_listener(registry, &registry_listener, NULL);
+    wl_display_roundtrip(client.display);
+
+    if (client.compositor == NULL || client.shm == NULL || client.wm_base == NULL) {
+        log("Compositor is missing a global needed by the bench client");
+    } else {
+        client.windows = calloc(client.windows_count, sizeof(*client.windows));
+        for (int i = 0; i < client.windows_count; i++) {
+            window_init(&client.windows[i], i);
+        }
+
+        // Returns once the compositor closes the connection
+        while (wl_display_dispatch(client.display) != -1);
+
+        for (int i = 0; i < client.windows_count; i++) {
+            window_finish(&client.windows[i]);
+        }
+        free(client.windows);
+    }
+
+    if (client.wm_base != NULL) xdg_wm_base_destroy(client.wm_base);
+    if (client.shm != NULL) wl_shm_destroy(client.shm);
+    if (client.compositor != NULL) wl_compositor_destroy(client.compositor);
+    wl_registry_destroy(registry);
+    wl_display_disconnect(client.display);
+    return NULL;
+}
+
+void bench_start_clients(int fd, int count) {
+    client = (Client){ 0 };
+    client.fd = fd;
+    client.windows_count = count;
+
+    if (pthread_create(&client.thread, NULL, client_run, NULL) != 0) {
+        log("Fail to start bench client thread");
+        close(fd);
+        client.fd = -1;
+    }
+}
+
+void bench_stop_clients(void) {
+    if (client.fd < 0) return;
+    pthread_join(client.thread, NULL);
+}
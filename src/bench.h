@@ -0,0 +1,21 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Allocations are counted by forwarding malloc to the glibc entry points behind it, other C libraries have none
+#ifdef __GLIBC__
+#define BENCH_COUNT_ALLOCATIONS
+#endif
+
+// Opens windows from minimal xdg-shell clients on a thread of their own, fd is a connected socket
+void bench_start_clients(int fd, int count);
+
+// Waits for the client thread, call once the compositor side of the connection is closed
+void bench_stop_clients(void);
+
+// Heap allocations made so far by the calling thread, always 0 without BENCH_COUNT_ALLOCATIONS
+uint64_t bench_allocations(void);
+
+#endif
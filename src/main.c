@@ -1,21 +1,31 @@
 #include <stdint.h>
+#include <inttypes.h>
+#include <signal.h>
 #include <time.h>
 #include <unistd.h>
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/timerfd.h>
 #include <wayland-server-core.h>
 #include <wayland-server-protocol.h>
 #include <wayland-util.h>
+#include <pixman.h>
 #include <wlr/backend.h>
+#include <wlr/backend/headless.h>
 #include <wlr/render/allocator.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/render/gles2.h>
+#include <wlr/render/pixman.h>
 #include <wlr/render/swapchain.h>
 #include <wlr/types/wlr_compositor.h>
+#include <wlr/types/wlr_damage_ring.h>
 #include <wlr/types/wlr_subcompositor.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_output_layout.h>
+#include <wlr/types/wlr_presentation_time.h>
+#include <wlr/types/wlr_scene.h>
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/types/wlr_seat.h>
 #include <wlr/types/wlr_cursor.h>
@@ -28,10 +38,25 @@
 #include <wlr/util/box.h>
 #include <xkbcommon/xkbcommon.h>
 
+#ifdef HEADLESS_BENCHMARK
+#include <sys/socket.h>
+#include "bench.h"
+#endif
+
+// Physics is stepped from the wl_display event loop, so the renderer never races the solver
+// Islands are solved on that thread too, a worker pool would bring back the threads and locks the event loop avoids
 #define PHYSAC_IMPLEMENTATION
 #define PHYSAC_STANDALONE
+#define PHYSAC_NO_THREADS
+#define PHYSAC_NO_WORKERS
 #include <physac.h>
 
+// Windows closer than this to upright (in radians) are left to the scene graph
+#define UPRIGHT_EPSILON 0.001f
+
+// Fixed physics step (240 Hz), output_frame interpolates between steps so it does not need to match the refresh rate
+#define PHYSICS_TIME_STEP_NS 4166667
+
 #define log(...) fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n")
 
 // #define DEBUG true
@@ -55,6 +80,16 @@
     void _##name##_##event(struct name *name, void *data)
 #endif
 
+// Log2 buckets of microseconds, bucket i counts samples under 2^(i+1) us, the last one everything above
+#define HISTOGRAM_BUCKETS 16
+
+typedef struct histogram {
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} Histogram;
+
 typedef struct server {
     struct wl_display *display;
     struct wlr_backend *backend;
@@ -64,6 +99,9 @@ typedef struct server {
 
     struct wlr_output_layout *output_layout;
     struct wl_list outputs;
+
+    struct wlr_scene *scene;
+    struct wlr_scene_output_layout *scene_layout;
     struct wl_listener new_output;
 
     struct wlr_xdg_shell *xdg_shell;
@@ -85,14 +123,95 @@ typedef struct server {
     struct wl_listener request_set_selection;
 
     PhysicsBody floor;
+    int physics_timer_fd;
+    struct wl_event_source *physics_timer;
+    bool physics_timer_armed;
+    Histogram physics_time;
+
+    struct wlr_presentation *presentation;
+    struct wl_event_source *stats_signal;
+
+    // Milliseconds kept before vblank for repainting, 0 repaints right away, MAX_RENDER_TIME_AUTO measures it
+    int max_render_time;
+
+    // Client buffers imported into textures, counted per second of CLOCK_MONOTONIC
+    unsigned int texture_uploads;
+    unsigned int texture_uploads_per_second;
+    time_t texture_uploads_second;
+
+#ifdef HEADLESS_BENCHMARK
+    // Windows to wait for before measuring, then frames left to measure
+    int bench_windows;
+    int bench_frames;
+    uint64_t bench_frames_measured;
+    uint64_t bench_allocations;
+    uint64_t bench_allocations_max;
+#endif
 } Server;
 
+// Output state and buffer of the frame being rendered, recycled instead of allocated every frame
+typedef struct frame {
+    struct wlr_output_state state;
+    struct wlr_buffer *buffer;
+    int buffer_age;
+    struct wlr_render_pass *render_pass;
+} Frame;
+
+// Textured quad of a toplevel collected for the custom render path
+typedef struct quad {
+    struct toplevel *toplevel;
+    bool rotated;
+    struct wlr_box box;     // Destination of upright quads
+    float matrix[9];        // Model matrix of rotated quads, projected by the renderer
+} Quad;
+
+#define MAX_RENDER_TIME_AUTO -1
+
+// Slack added to the measured render time when max render time is automatic
+#define RENDER_TIME_MARGIN_NS 1000000
+
 typedef struct output {
     struct server *server;
     struct wl_list link;
     struct wlr_output *base;
 
+    struct wlr_scene_output *scene_output;
+
+    // Damage accumulated since each swapchain buffer was last drawn by the custom rotated path
+    struct wlr_damage_ring damage_ring;
+    bool custom_render;
+
+    // A client buffer is on screen, swapchain buffers were not updated since
+    bool scanout;
+
+    // Every frame is rendered and committed within one repaint, a single one is enough
+    Frame frame;
+
+    // Quads of the frame being rendered, storage is kept between frames
+    struct wl_array quads;
+
+    // Frame timing statistics, dumped with Alt+F2 or SIGUSR1
+    struct timespec frame_start;
+    struct timespec commit_time;
+    uint32_t commit_seq;
+    Histogram render_time;
+    Histogram present_latency;
+    uint64_t missed_vblanks;
+
+    // Repaint delayed towards the next vblank, see Server.max_render_time
+    struct wl_event_source *repaint_timer;
+    bool repaint_pending;
+    struct timespec last_present;
+    int refresh_ns;
+    uint64_t recent_render_ns;
+
+    // Physics world of the windows placed on this output, with its own floor and walls
+    PhysicsWorld world;
+    struct wl_list physics_toplevels;
+
     struct wl_listener frame;
+    struct wl_listener present;
+    struct wl_listener destroy;
 } Output;
 
 typedef struct toplevel {
@@ -100,12 +219,30 @@ typedef struct toplevel {
     struct wl_list link;
     struct wlr_xdg_toplevel *base;
 
-    // Physac
+    // Physac, the body lives in the world of output
     Vector2 pos, size;
     PhysicsBody body;
+    struct output *output;
+    struct wl_list physics_link;
+
+    // Only used while the window is upright, rotated windows go through the custom render path
+    struct wlr_scene_tree *scene_tree;
+
+    // Texture of the last committed buffer, refreshed on commit only
+    struct wlr_texture *texture;
+    uint32_t texture_seq;
+
+    // Transform and bounding box of the last rendered frame
+    Vector2 render_pos, render_size;
+    float render_rotation;
+    struct wlr_box render_box;
+
+    // Part of the damaged area where this window is not hidden by opaque windows above it
+    pixman_region32_t visible;
 
     struct wl_listener map;
     struct wl_listener unmap;
+    struct wl_listener commit;
     struct wl_listener destroy;
 } Toplevel;
 
@@ -137,15 +274,175 @@ listener_definition(server_cursor_frame);
 listener_definition(server_new_input);
 
 listener_definition(output_frame);
+listener_definition(output_present);
+int handle_repaint_timer(void *data);
+listener_definition(output_destroy);
 
 listener_definition(toplevel_map);
 listener_definition(toplevel_unmap);
+listener_definition(toplevel_commit);
 listener_definition(toplevel_destroy);
 
 listener_definition(keyboard_modifiers);
 listener_definition(keyboard_key);
 listener_definition(keyboard_destroy);
 
+// Boxes are local to the output whose world holds the toplevel, no other output shows it
+void damage_toplevel_output(Toplevel *toplevel, const struct wlr_box *box) {
+    Output *output = toplevel->output;
+    if (output == NULL) return;
+
+    if (wlr_damage_ring_add_box(&output->damage_ring, box)) {
+        wlr_output_schedule_frame(output->base);
+    }
+}
+
+// Outputs are kept in the order they were added, the same order the layout places them from left to right
+Output *first_output(Server *server) {
+    if (wl_list_empty(&server->outputs)) return NULL;
+
+    Output *output = wl_container_of(server->outputs.next, output, link);
+    return output;
+}
+
+// Returns the output bounding box of a window-local rectangle once the window is rotated around its center
+struct wlr_box transform_box(const struct wlr_box *local, Vector2 size, Vector2 position, float rotation) {
+    float c = cosf(rotation);
+    float s = sinf(rotation);
+
+    float corners[4][2] = {
+        { local->x, local->y },
+        { local->x + local->width, local->y },
+        { local->x, local->y + local->height },
+        { local->x + local->width, local->y + local->height },
+    };
+
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (int i = 0; i < 4; i++) {
+        float x = corners[i][0] - size.x / 2;
+        float y = corners[i][1] - size.y / 2;
+        float rx = x * c - y * s + position.x;
+        float ry = x * s + y * c + position.y;
+
+        min_x = fminf(min_x, rx);
+        min_y = fminf(min_y, ry);
+        max_x = fmaxf(max_x, rx);
+        max_y = fmaxf(max_y, ry);
+    }
+
+    // One extra pixel on every side covers texture filtering on rotated edges
+    struct wlr_box box = {
+        .x = (int)floorf(min_x) - 1,
+        .y = (int)floorf(min_y) - 1,
+    };
+    box.width = (int)ceilf(max_x) + 1 - box.x;
+    box.height = (int)ceilf(max_y) + 1 - box.y;
+    return box;
+}
+
+void arm_physics_timer(Server *server, bool armed) {
+    if (server->physics_timer_armed == armed) return;
+
+    // A zeroed it_value disarms the timer
+    struct itimerspec spec = { 0 };
+    if (armed) {
+        spec.it_interval.tv_nsec = PHYSICS_TIME_STEP_NS;
+        spec.it_value.tv_nsec = PHYSICS_TIME_STEP_NS;
+    }
+
+    if (timerfd_settime(server->physics_timer_fd, 0, &spec, NULL) != 0) {
+        log("Fail to set physics timer");
+        return;
+    }
+    server->physics_timer_armed = armed;
+}
+
+uint64_t timespec_to_ns(const struct timespec *time) {
+    return (uint64_t)time->tv_sec * 1000000000 + time->tv_nsec;
+}
+
+void histogram_add(Histogram *histogram, uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+    while (bucket < HISTOGRAM_BUCKETS - 1 && us >= (2ull << bucket)) bucket++;
+
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total_ns += ns;
+    if (ns > histogram->max_ns) histogram->max_ns = ns;
+}
+
+// Steps the world of every output, outputs whose world simulated a step get a frame to show it
+void run_physics_step(Server *server) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Output *output;
+    wl_list_for_each(output, &server->outputs, link) {
+        unsigned int steps = GetPhysicsStepsCount(output->world);
+        RunPhysicsStep(output->world);
+        if (GetPhysicsStepsCount(output->world) != steps) wlr_output_schedule_frame(output->base);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    histogram_add(&server->physics_time, timespec_to_ns(&end) - timespec_to_ns(&start));
+}
+
+int handle_physics_timer(int fd, uint32_t mask, void *data) {
+    Server *server = data;
+
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return 0;
+
+    // RunPhysicsStep catches up on missed expirations through its accumulator
+    run_physics_step(server);
+
+    // Every body is resting, nothing to do until a toplevel is mapped or destroyed
+    bool awake = false;
+    Output *output;
+    wl_list_for_each(output, &server->outputs, link) {
+        if (GetPhysicsAwakeBodiesCount(output->world) > 0) awake = true;
+    }
+    if (!awake) arm_physics_timer(server, false);
+
+    return 0;
+}
+
+PhysicsWorld create_physics_world(void) {
+    PhysicsWorld world = CreatePhysicsWorld();
+    SetPhysicsGravity(world, 0, 1);
+
+    // Resting piles converge in a few iterations, and a stalled compositor should not replay seconds of physics at once
+    PhysicsSolverSettings settings = GetPhysicsSolverSettings(world);
+    settings.timeStep = (double)PHYSICS_TIME_STEP_NS / 1000000;
+    settings.maxSubsteps = 8;
+    settings.adaptiveIterations = true;
+    SetPhysicsSolverSettings(world, settings);
+
+    return world;
+}
+
+// Creates the body of a toplevel in the world of an output, it only collides with windows of the same output
+void toplevel_create_body(Toplevel *toplevel, Output *output, Vector2 pos, float rotation) {
+    toplevel->body = CreatePhysicsBodyRectangle(output->world, pos, toplevel->size.x, toplevel->size.y, 1);
+    if (toplevel->body == NULL) {
+        log("Fail to create the physics body of a window");
+        return;
+    }
+
+    toplevel->output = output;
+    SetPhysicsBodyRotation(toplevel->body, rotation);
+
+    // Read by the render path before the next snapshot carries the body transform
+    toplevel->render_pos = pos;
+    toplevel->render_size = toplevel->size;
+    toplevel->render_rotation = rotation;
+
+    wl_list_insert(&output->physics_toplevels, &toplevel->physics_link);
+    arm_physics_timer(toplevel->server, true);
+}
+
 void focus_toplevel(Toplevel *toplevel, struct wlr_surface *surface) {
     if (toplevel == NULL) return;
 
@@ -168,6 +465,29 @@ void focus_toplevel(Toplevel *toplevel, struct wlr_surface *surface) {
     }
 }
 
+void frame_init(Frame *frame) {
+    wlr_output_state_init(&frame->state);
+    frame->buffer = NULL;
+    frame->buffer_age = -1;
+    frame->render_pass = NULL;
+}
+
+void frame_finish(Frame *frame) {
+    if (frame->buffer != NULL) {
+        wlr_buffer_unlock(frame->buffer);
+        frame->buffer = NULL;
+    }
+    frame->render_pass = NULL;
+
+    wlr_output_state_finish(&frame->state);
+}
+
+// Empties a frame whatever happened to it, dropping its buffer and state so the next repaint starts clean
+void frame_release(Frame *frame) {
+    frame_finish(frame);
+    wlr_output_state_init(&frame->state);
+}
+
 server_listener(new_output, data) {
     struct wlr_output *wlr_output = data;
 
@@ -177,8 +497,9 @@ server_listener(new_output, data) {
     wlr_output_state_init(&state);
     wlr_output_state_set_enabled(&state, true);
 
+    // Headless outputs have no modes, they keep the size they were created with
     struct wlr_output_mode *mode = wlr_output_preferred_mode(wlr_output);
-    wlr_output_state_set_mode(&state, mode);
+    if (mode != NULL) wlr_output_state_set_mode(&state, mode);
 
     wlr_output_commit_state(wlr_output, &state);
     wlr_output_state_finish(&state);
@@ -187,31 +508,66 @@ server_listener(new_output, data) {
     output->server = server;
     output->base = wlr_output;
 
+    wlr_damage_ring_init(&output->damage_ring);
+    wlr_damage_ring_set_bounds(&output->damage_ring, wlr_output->width, wlr_output->height);
+    wlr_damage_ring_add_whole(&output->damage_ring);
+    output->custom_render = false;
+    output->scanout = false;
+
+    output->scene_output = wlr_scene_output_create(server->scene, wlr_output);
+
+    frame_init(&output->frame);
+    wl_array_init(&output->quads);
+
+    output->commit_seq = 0;
+    output->render_time = (Histogram){ 0 };
+    output->present_latency = (Histogram){ 0 };
+    output->missed_vblanks = 0;
+
+    output->repaint_timer = wl_event_loop_add_timer(wl_display_get_event_loop(server->display), handle_repaint_timer, output);
+    output->repaint_pending = false;
+    output->last_present = (struct timespec){ 0 };
+    output->refresh_ns = 0;
+    output->recent_render_ns = 0;
+
+    output->world = create_physics_world();
+    wl_list_init(&output->physics_toplevels);
+
     output->frame.notify = output_frame;
     wl_signal_add(&wlr_output->events.frame, &output->frame);
 
-    wl_list_insert(&server->outputs, &output->link);
+    output->present.notify = output_present;
+    wl_signal_add(&wlr_output->events.present, &output->present);
+
+    output->destroy.notify = output_destroy;
+    wl_signal_add(&wlr_output->events.destroy, &output->destroy);
 
-    /* struct wlr_output_layout_output *layout_output =*/ wlr_output_layout_add_auto(server->output_layout, wlr_output);
+    wl_list_insert(server->outputs.prev, &output->link);
 
-    // We add a floor and two walls for the new output
+    struct wlr_output_layout_output *layout_output = wlr_output_layout_add_auto(server->output_layout, wlr_output);
+    wlr_scene_output_layout_add_output(server->scene_layout, layout_output, output->scene_output);
+
+    // We add a floor and two walls to the world of the new output
     PhysicsBody floor = CreatePhysicsBodyRectangle(
+        output->world,
         (Vector2){ (float)wlr_output->width / 2, wlr_output->height },
         wlr_output->width, 1, 1
     );
-    floor->enabled = false;
+    if (floor != NULL) floor->enabled = false;
 
     PhysicsBody left_wall = CreatePhysicsBodyRectangle(
+        output->world,
         (Vector2){ 0, (float)wlr_output->height / 2 },
         1, wlr_output->height, 1
     );
-    left_wall->enabled = false;
+    if (left_wall != NULL) left_wall->enabled = false;
 
     PhysicsBody right_wall = CreatePhysicsBodyRectangle(
+        output->world,
         (Vector2){ wlr_output->width, (float)wlr_output->height / 2 },
         1, wlr_output->height, 1
     );
-    right_wall->enabled = false;
+    if (right_wall != NULL) right_wall->enabled = false;
 }
 
 server_listener(new_xdg_surface, data) {
@@ -223,10 +579,27 @@ server_listener(new_xdg_surface, data) {
     Toplevel *toplevel = malloc(sizeof(*toplevel));
     toplevel->server = server;
     toplevel->base = xdg_toplevel;
-    Output *output = wl_container_of(server->outputs.next, output, link);
-    toplevel->pos.x = (float)output->base->width / 2;
+
+    // New windows fall from the middle of the first output, the world they join once mapped
+    Output *output = first_output(server);
+    toplevel->pos.x = output != NULL ? (float)output->base->width / 2 : 0;
     toplevel->pos.y = -400;
+    toplevel->size = (Vector2){ 0 };
     toplevel->body = NULL;
+    toplevel->output = NULL;
+    wl_list_init(&toplevel->physics_link);
+    toplevel->texture = NULL;
+    toplevel->texture_seq = 0;
+    toplevel->render_pos = toplevel->pos;
+    toplevel->render_size = (Vector2){ 0 };
+    toplevel->render_rotation = 0;
+    toplevel->render_box = (struct wlr_box){ 0 };
+    pixman_region32_init(&toplevel->visible);
+
+    // New windows go under the existing ones, like the custom render path draws them
+    toplevel->scene_tree = wlr_scene_xdg_surface_create(&server->scene->tree, xdg_surface);
+    wlr_scene_node_set_enabled(&toplevel->scene_tree->node, false);
+    wlr_scene_node_lower_to_bottom(&toplevel->scene_tree->node);
 
     toplevel->map.notify = toplevel_map;
     wl_signal_add(&xdg_surface->surface->events.map, &toplevel->map);
@@ -234,6 +607,9 @@ server_listener(new_xdg_surface, data) {
     toplevel->unmap.notify = toplevel_unmap;
     wl_signal_add(&xdg_surface->surface->events.unmap, &toplevel->unmap);
 
+    toplevel->commit.notify = toplevel_commit;
+    wl_signal_add(&xdg_surface->surface->events.commit, &toplevel->commit);
+
     toplevel->destroy.notify = toplevel_destroy;
     wl_signal_add(&xdg_surface->surface->events.destroy, &toplevel->destroy);
 }
@@ -318,22 +694,64 @@ server_listener(cursor_frame, data) {
     wlr_seat_pointer_notify_frame(server->seat);
 }
 
-typedef struct frame {
-    struct wlr_output_state state;
-    struct wlr_buffer *buffer;
-    int buffer_age;
-    struct wlr_render_pass *render_pass;
-} Frame;
+void histogram_log(const char *name, Histogram *histogram) {
+    if (histogram->count == 0) {
+        log("  %s: no samples", name);
+        return;
+    }
 
-Frame *frame_create() {
-    Frame *frame = malloc(sizeof(*frame));
-    wlr_output_state_init(&frame->state);
-    return frame;
+    log("  %s: %" PRIu64 " samples, avg %.3f ms, max %.3f ms", name, histogram->count,
+        (double)histogram->total_ns / histogram->count / 1000000, (double)histogram->max_ns / 1000000);
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (histogram->buckets[i] == 0) continue;
+        if (i == HISTOGRAM_BUCKETS - 1) {
+            log("    >= %.3f ms: %" PRIu64, (double)(1ull << i) / 1000, histogram->buckets[i]);
+        } else {
+            log("    < %.3f ms: %" PRIu64, (double)(2ull << i) / 1000, histogram->buckets[i]);
+        }
+    }
 }
 
-void frame_destroy(Frame *frame) {
-    wlr_output_state_finish(&frame->state);
-    free(frame);
+void log_frame_stats(Server *server) {
+    log("Physics:");
+    histogram_log("step time", &server->physics_time);
+
+    Output *output;
+    wl_list_for_each(output, &server->outputs, link) {
+        log("Output %s:", output->base->name);
+
+        unsigned int steps = GetPhysicsStepsCount(output->world);
+        log("  physics: %d bodies, %u steps", GetPhysicsBodiesCount(output->world), steps);
+        if (steps > 0) {
+            log("  solver iterations: %.2f per step", (double)GetPhysicsIterationsCount(output->world) / steps);
+        }
+        unsigned int dropped = GetPhysicsDroppedManifoldsCount(output->world);
+        if (dropped > 0) {
+            log("  dropped contacts: %u, the manifolds arena could not grow", dropped);
+        }
+
+        histogram_log("render time", &output->render_time);
+        histogram_log("commit to present", &output->present_latency);
+        log("  missed vblanks: %" PRIu64, output->missed_vblanks);
+    }
+}
+
+int handle_stats_signal(int signal_number, void *data) {
+    log_frame_stats(data);
+    return 0;
+}
+
+// Called once a frame reached the output, render time runs from the frame event to the commit
+void output_record_commit(Output *output) {
+    clock_gettime(CLOCK_MONOTONIC, &output->commit_time);
+    output->commit_seq = output->base->commit_seq;
+
+    uint64_t render_ns = timespec_to_ns(&output->commit_time) - timespec_to_ns(&output->frame_start);
+    histogram_add(&output->render_time, render_ns);
+
+    // Peak of recent frames, decaying so one slow frame does not pin the estimate forever
+    output->recent_render_ns -= output->recent_render_ns / 8;
+    if (render_ns > output->recent_render_ns) output->recent_render_ns = render_ns;
 }
 
 void acquire_swapchain_buffer(struct wlr_output *output, Frame *frame) {
@@ -343,100 +761,681 @@ void acquire_swapchain_buffer(struct wlr_output *output, Frame *frame) {
     frame->buffer = wlr_swapchain_acquire(output->swapchain, &frame->buffer_age);
 }
 
-Frame *start_frame(struct wlr_output *output) {
-    Frame *frame = frame_create();
+Frame *start_frame(Output *output) {
+    Frame *frame = &output->frame;
 
-    acquire_swapchain_buffer(output, frame);
+    acquire_swapchain_buffer(output->base, frame);
+    if (frame->buffer == NULL) {
+        frame_release(frame);
+        return NULL;
+    }
 
-    frame->render_pass = wlr_renderer_begin_buffer_pass(output->renderer, frame->buffer, NULL);
+    frame->render_pass = wlr_renderer_begin_buffer_pass(output->base->renderer, frame->buffer, NULL);
+    if (frame->render_pass == NULL) {
+        frame_release(frame);
+        return NULL;
+    }
 
     return frame;
 }
 
-output_listener(frame, data) {
-    Frame *frame = start_frame(output->base);
+bool commit_frame(Output *output, Frame *frame) {
+    if (!wlr_render_pass_submit(frame->render_pass)) {
+        log("Fail to submit render_pass");
+        return false;
+    }
+    frame->render_pass = NULL;
+
+    wlr_output_state_set_buffer(&frame->state, frame->buffer);
+    wlr_output_state_set_damage(&frame->state, &output->damage_ring.current);
+
+    if (!wlr_output_test_state(output->base, &frame->state)) {
+        log("Output state test failed");
+        return false;
+    }
+
+    if (!wlr_output_commit_state(output->base, &frame->state)) {
+        log("Fail to commit output state");
+        return false;
+    }
+
+    return true;
+}
+
+bool toplevel_is_upright(Toplevel *toplevel) {
+    return fabsf(remainderf(toplevel->render_rotation, 2 * PHYSAC_PI)) < UPRIGHT_EPSILON;
+}
+
+// Moves a toplevel to its blended physics transform at a physics clock time, damaging where it was and where it is now.
+// Returns true while the body moved during the last physics step and the blend did not reach it, so later frames blend further.
+bool update_toplevel_transform(Toplevel *toplevel, double present_time) {
+    struct wlr_texture *texture = toplevel->texture;
+    if (texture == NULL || toplevel->body == NULL) return false;
+
+    // Render from the latest published snapshot of the toplevel world, never from live solver state
+    const PhysicsSnapshot *snapshot = GetPhysicsSnapshot(toplevel->output->world);
+    float alpha = GetPhysicsSnapshotAlpha(snapshot, present_time);
+
+    const PhysicsBodySnapshot *body = GetPhysicsSnapshotBody(snapshot, toplevel->body->id);
+    if (body == NULL) return false;
+
+    bool moving = (body->position.x != body->previousPosition.x
+        || body->position.y != body->previousPosition.y
+        || body->orient != body->previousOrient) && alpha < 1.0f;
+
+    toplevel->render_pos = GetPhysicsSnapshotBodyPosition(body, alpha);
+    toplevel->render_rotation = GetPhysicsSnapshotBodyOrient(body, alpha);
+    toplevel->render_size = (Vector2){ texture->width, texture->height };
+
+    // Upright windows are drawn by the scene graph, which tracks their damage and occlusion itself.
+    // Scene nodes are placed in layout coordinates, physics ones are local to the output of the world.
+    struct wlr_box output_box;
+    wlr_output_layout_get_box(toplevel->server->output_layout, toplevel->output->base, &output_box);
+
+    struct wlr_scene_node *node = &toplevel->scene_tree->node;
+    wlr_scene_node_set_enabled(node, toplevel_is_upright(toplevel));
+    wlr_scene_node_set_position(
+        node,
+        output_box.x + (int)roundf(toplevel->render_pos.x - toplevel->render_size.x / 2),
+        output_box.y + (int)roundf(toplevel->render_pos.y - toplevel->render_size.y / 2)
+    );
+
+    struct wlr_box local = { 0, 0, texture->width, texture->height };
+    struct wlr_box box = transform_box(&local, toplevel->render_size, toplevel->render_pos, toplevel->render_rotation);
+    if (wlr_box_equal(&box, &toplevel->render_box)) return moving;
+
+    damage_toplevel_output(toplevel, &toplevel->render_box);
+    damage_toplevel_output(toplevel, &box);
+    toplevel->render_box = box;
+    return moving;
+}
+
+bool toplevel_is_visible(Toplevel *toplevel, Output *output) {
+    if (toplevel->output != output) return false;
+
+    struct wlr_box output_box = { 0, 0, output->base->width, output->base->height };
+    struct wlr_box intersection;
+    return wlr_box_intersection(&intersection, &output_box, &toplevel->render_box);
+}
+
+// Adds the output area a toplevel is guaranteed to cover with opaque pixels.
+// Opaque rectangles of rotated windows are shrunk to the largest upright box that fits inside them.
+void add_opaque_region(Toplevel *toplevel, pixman_region32_t *occluded) {
+    struct wlr_surface *surface = toplevel->base->base->surface;
+
+    float c = cosf(toplevel->render_rotation);
+    float s = sinf(toplevel->render_rotation);
+
+    int rects_len;
+    pixman_box32_t *rects = pixman_region32_rectangles(&surface->opaque_region, &rects_len);
+    for (int i = 0; i < rects_len; i++) {
+        float half_width = (float)(rects[i].x2 - rects[i].x1) / 2;
+        float half_height = (float)(rects[i].y2 - rects[i].y1) / 2;
+        float x = rects[i].x1 + half_width - toplevel->render_size.x / 2;
+        float y = rects[i].y1 + half_height - toplevel->render_size.y / 2;
+        float center_x = x * c - y * s + toplevel->render_pos.x;
+        float center_y = x * s + y * c + toplevel->render_pos.y;
+
+        float k = fminf(
+            half_width / (half_width * fabsf(c) + half_height * fabsf(s)),
+            half_height / (half_width * fabsf(s) + half_height * fabsf(c))
+        );
+
+        // One pixel less on every side, edges of the quad are blended by texture filtering
+        int x1 = (int)ceilf(center_x - k * half_width) + 1;
+        int y1 = (int)ceilf(center_y - k * half_height) + 1;
+        int x2 = (int)floorf(center_x + k * half_width) - 1;
+        int y2 = (int)floorf(center_y + k * half_height) - 1;
+        if (x2 <= x1 || y2 <= y1) continue;
+
+        pixman_region32_union_rect(occluded, occluded, x1, y1, x2 - x1, y2 - y1);
+    }
+}
+
+// Collects back to front the quads of toplevels with something left to draw after occlusion
+void collect_quads(Output *output) {
+    output->quads.size = 0;
+
+    Toplevel *toplevel;
+    wl_list_for_each(toplevel, &output->server->toplevels, link) {
+        if (toplevel->output != output || toplevel->texture == NULL || !pixman_region32_not_empty(&toplevel->visible)) continue;
+
+        Quad *quad = wl_array_add(&output->quads, sizeof(*quad));
+        if (quad == NULL) return;
+
+        quad->toplevel = toplevel;
+        quad->rotated = !toplevel_is_upright(toplevel);
+        quad->box = (struct wlr_box){
+            .x = (int)roundf(toplevel->render_pos.x - toplevel->render_size.x / 2),
+            .y = (int)roundf(toplevel->render_pos.y - toplevel->render_size.y / 2),
+            .width = toplevel->texture->width,
+            .height = toplevel->texture->height,
+        };
+
+        float model[9];
+        wlr_matrix_identity(model);
+        wlr_matrix_translate(model, toplevel->render_pos.x, toplevel->render_pos.y);
+        wlr_matrix_rotate(model, toplevel->render_rotation);
+
+        struct wlr_box local = {
+            -(int)toplevel->texture->width / 2, -(int)toplevel->texture->height / 2,
+            toplevel->texture->width, toplevel->texture->height,
+        };
+        wlr_matrix_project_box(quad->matrix, &local, WL_OUTPUT_TRANSFORM_NORMAL, 0, model);
+    }
+}
+
+bool quads_overlap(Quad *a, Quad *b) {
+    pixman_box32_t *ea = pixman_region32_extents(&a->toplevel->visible);
+    pixman_box32_t *eb = pixman_region32_extents(&b->toplevel->visible);
+    return ea->x1 < eb->x2 && eb->x1 < ea->x2 && ea->y1 < eb->y2 && eb->y1 < ea->y2;
+}
+
+// Moves upright quads ahead of rotated ones so they share a single render pass.
+// Neighbours only swap when they do not overlap, which keeps the stacking order visible on screen.
+void sort_quads(Output *output) {
+    Quad *quads = output->quads.data;
+    size_t count = output->quads.size / sizeof(Quad);
+
+    for (size_t i = 1; i < count; i++) {
+        for (size_t j = i; j > 0; j--) {
+            if (!quads[j - 1].rotated || quads[j].rotated) break;
+            if (quads_overlap(&quads[j - 1], &quads[j])) break;
+
+            Quad swap = quads[j - 1];
+            quads[j - 1] = quads[j];
+            quads[j] = swap;
+        }
+    }
+}
+
+// Upright quads go through the render pass with their visible region as clip, the pass cannot rotate
+// so everything from the first rotated quad on is drawn with the matrix renderer, one scissor per rectangle
+void render_quads(Output *output, Frame *frame, pixman_region32_t *background) {
     struct wlr_renderer *renderer = output->base->renderer;
+    Quad *quads = output->quads.data;
+    size_t count = output->quads.size / sizeof(Quad);
+
+    wlr_render_pass_add_rect(frame->render_pass, &(struct wlr_render_rect_options){
+        .box = { 0, 0, output->base->width, output->base->height },
+        .color = { 0, 0, 0, 1 },
+        .clip = background,
+    });
+
+    size_t i = 0;
+    for (; i < count && !quads[i].rotated; i++) {
+        wlr_render_pass_add_texture(frame->render_pass, &(struct wlr_render_texture_options){
+            .texture = quads[i].toplevel->texture,
+            .dst_box = quads[i].box,
+            .clip = &quads[i].toplevel->visible,
+        });
+    }
+    if (i == count) return;
 
     wlr_renderer_begin_with_buffer(renderer, frame->buffer);
+    for (; i < count; i++) {
+        int rects_len;
+        pixman_box32_t *rects = pixman_region32_rectangles(&quads[i].toplevel->visible, &rects_len);
+        for (int r = 0; r < rects_len; r++) {
+            struct wlr_box scissor = {
+                .x = rects[r].x1,
+                .y = rects[r].y1,
+                .width = rects[r].x2 - rects[r].x1,
+                .height = rects[r].y2 - rects[r].y1,
+            };
+            wlr_renderer_scissor(renderer, &scissor);
+            wlr_render_texture_with_matrix(renderer, quads[i].toplevel->texture, quads[i].matrix, 1.0);
+        }
+    }
+    wlr_renderer_scissor(renderer, NULL);
+    wlr_renderer_end(renderer);
+}
 
-    wlr_renderer_clear(renderer, (float[]){ 0, 0, 0, 1 });
+// Reports textured surfaces to wp_presentation before the commit, so their feedback follows this frame
+void output_present_surfaces(Output *output, bool scanout) {
+    struct wlr_presentation *presentation = output->server->presentation;
 
     Toplevel *toplevel;
     wl_list_for_each(toplevel, &output->server->toplevels, link) {
+        if (!toplevel_is_visible(toplevel, output)) continue;
+
         struct wlr_surface *surface = toplevel->base->base->surface;
-        struct wlr_texture *texture = wlr_surface_get_texture(surface);
-
-        PhysicsBody body = toplevel->body;
-        Vector2 position = body->position;
-        float rotation = body->orient;
-        float half_width = (float)texture->width / 2;
-        float half_height = (float)texture->height / 2;
-
-        float proj[9];
-        wlr_matrix_identity(proj);
-        wlr_matrix_translate(proj, position.x, position.y);
-        wlr_matrix_rotate(proj, rotation);
-
-        wlr_render_texture(
-            renderer,
-            texture,
-            proj,
-            -half_width, -half_height, 1.0
-        );
+        if (scanout) {
+            wlr_presentation_surface_scanned_out_on_output(presentation, surface, output->base);
+        } else {
+            wlr_presentation_surface_textured_on_output(presentation, surface, output->base);
+        }
+    }
+}
+
+// Only surfaces shown on this output are told to draw their next frame
+void send_frame_done(Output *output) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    Toplevel *toplevel;
+    wl_list_for_each(toplevel, &output->server->toplevels, link) {
+        if (!toplevel_is_visible(toplevel, output)) continue;
+        wlr_surface_send_frame_done(toplevel->base->base->surface, &now);
+    }
+}
+
+// A single upright window covering the whole output is put on screen without compositing
+bool output_try_direct_scanout(Output *output) {
+    Toplevel *fullscreen = NULL;
+    Toplevel *toplevel;
+    wl_list_for_each(toplevel, &output->server->toplevels, link) {
+        if (!toplevel_is_visible(toplevel, output)) continue;
+        if (fullscreen != NULL) return false;
+        fullscreen = toplevel;
+    }
+    if (fullscreen == NULL || !toplevel_is_upright(fullscreen)) return false;
+
+    struct wlr_surface *surface = fullscreen->base->base->surface;
+    if (surface->buffer == NULL) return false;
+    if (surface->current.transform != output->base->transform) return false;
+    if (!wl_list_empty(&surface->current.subsurfaces_below) || !wl_list_empty(&surface->current.subsurfaces_above)) return false;
+
+    struct wlr_buffer *buffer = &surface->buffer->base;
+    int x = (int)roundf(fullscreen->render_pos.x - fullscreen->render_size.x / 2);
+    int y = (int)roundf(fullscreen->render_pos.y - fullscreen->render_size.y / 2);
+    if (x != 0 || y != 0 || buffer->width != output->base->width || buffer->height != output->base->height) return false;
+
+    // The client buffer is already on screen and did not change
+    if (output->scanout && !pixman_region32_not_empty(&output->damage_ring.current)) {
+        send_frame_done(output);
+        return true;
+    }
+
+    Frame *frame = &output->frame;
+    wlr_output_state_set_buffer(&frame->state, buffer);
+
+    // The backend may refuse the client buffer (format, modifiers, size), compose it instead
+    if (!wlr_output_test_state(output->base, &frame->state)) {
+        frame_release(frame);
+        return false;
+    }
+
+    output_present_surfaces(output, true);
+
+    bool committed = wlr_output_commit_state(output->base, &frame->state);
+    frame_release(frame);
+    if (!committed) {
+        log("Fail to commit direct scanout");
+        return false;
+    }
+    output_record_commit(output);
+
+    wlr_damage_ring_rotate(&output->damage_ring);
+    output->scanout = true;
+
+    send_frame_done(output);
+    return true;
+}
+
+void output_render(Output *output) {
+    Server *server = output->server;
+
+    // Render one step behind the simulation, the time left in the physics accumulator blends the last two steps
+    double present_time = GetPhysicsTime();
+
+    bool moving = false;
+    Toplevel *toplevel;
+    wl_list_for_each(toplevel, &server->toplevels, link) {
+        if (toplevel->output != output) continue;
+        moving |= update_toplevel_transform(toplevel, present_time);
+    }
+
+    // Keep blending until the latest physics step is fully presented
+    if (moving) wlr_output_schedule_frame(output->base);
+
+    if (output_try_direct_scanout(output)) return;
+
+    // The client buffer was on screen, swapchain buffers of both render paths are stale
+    if (output->scanout) {
+        wlr_damage_ring_add_whole(&output->damage_ring);
+        wlr_damage_ring_add_whole(&output->scene_output->damage_ring);
+        output->scanout = false;
+    }
+
+    bool rotated = false;
+    wl_list_for_each(toplevel, &server->toplevels, link) {
+        if (!toplevel_is_upright(toplevel) && toplevel_is_visible(toplevel, output)) {
+            rotated = true;
+            break;
+        }
+    }
+
+    // Fast path, the scene graph handles damage, occlusion and scanout when nothing is rotated
+    if (!rotated) {
+        if (output->custom_render) {
+            wlr_damage_ring_add_whole(&output->scene_output->damage_ring);
+            output->custom_render = false;
+        }
+
+        // The scene only commits when it has damage
+        uint32_t commit_seq = output->base->commit_seq;
+        if (!wlr_scene_output_commit(output->scene_output, NULL)) {
+            log("Fail to commit scene output");
+        } else if (output->base->commit_seq != commit_seq) {
+            output_record_commit(output);
+        }
 
         struct timespec now;
         clock_gettime(CLOCK_MONOTONIC, &now);
-        wlr_surface_send_frame_done(surface, &now);
+        wlr_scene_output_send_frame_done(output->scene_output, &now);
+        return;
     }
-    
-    wlr_renderer_end(renderer);
 
-    if (!wlr_render_pass_submit(frame->render_pass)) {
-        log("Fail to submit render_pass");
-        wlr_buffer_unlock(frame->buffer);
+    // Buffers were last drawn by the scene graph, none of their contents can be trusted
+    if (!output->custom_render) {
+        wlr_damage_ring_add_whole(&output->damage_ring);
+        output->custom_render = true;
+    }
+
+    // Nothing changed on this output, leave the current buffer on screen
+    if (!pixman_region32_not_empty(&output->damage_ring.current)) {
+        send_frame_done(output);
         return;
     }
 
-    wlr_output_state_set_buffer(&frame->state, frame->buffer);
-    wlr_buffer_unlock(frame->buffer);
+    Frame *frame = start_frame(output);
+    if (frame == NULL) {
+        log("Fail to start frame");
+        send_frame_done(output);
+        return;
+    }
 
-    if (!wlr_output_test_state(output->base, &frame->state)) {
-        log("Output state test failed");
+    // Repaint what changed since this buffer was last drawn, according to its age
+    pixman_region32_t damage;
+    pixman_region32_init(&damage);
+    wlr_damage_ring_get_buffer_damage(&output->damage_ring, frame->buffer_age, &damage);
+
+    // Walk from the top window down, each one only keeps what opaque windows above it leave uncovered
+    pixman_region32_t occluded;
+    pixman_region32_init(&occluded);
+    wl_list_for_each_reverse(toplevel, &server->toplevels, link) {
+        if (toplevel->output != output) continue;
+
+        struct wlr_box *box = &toplevel->render_box;
+        pixman_region32_intersect_rect(&toplevel->visible, &damage, box->x, box->y, box->width, box->height);
+        pixman_region32_subtract(&toplevel->visible, &toplevel->visible, &occluded);
+        add_opaque_region(toplevel, &occluded);
+    }
+
+    // Only clear what no opaque window covers
+    pixman_region32_t background;
+    pixman_region32_init(&background);
+    pixman_region32_subtract(&background, &damage, &occluded);
+
+    // Fully covered windows have an empty visible region and produce no quad
+    collect_quads(output);
+    sort_quads(output);
+    render_quads(output, frame, &background);
+
+    pixman_region32_fini(&background);
+    pixman_region32_fini(&occluded);
+    pixman_region32_fini(&damage);
+
+    send_frame_done(output);
+    output_present_surfaces(output, false);
+
+    if (commit_frame(output, frame)) {
+        wlr_damage_ring_rotate(&output->damage_ring);
+        output_record_commit(output);
+    }
+    frame_release(frame);
+}
+
+#ifdef HEADLESS_BENCHMARK
+// Frames only count once every window is mapped, statistics collected while they appear are dropped
+void bench_record_frame(Output *output, uint64_t allocations) {
+    Server *server = output->server;
+    if (server->bench_frames == 0) return;
+
+    if (wl_list_length(&server->toplevels) < server->bench_windows) {
+        wlr_output_schedule_frame(output->base);
         return;
     }
 
-    if (!wlr_output_commit_state(output->base, &frame->state)) {
-        log("Fail to commit output state");
+    if (server->bench_frames_measured == 0) {
+        server->physics_time = (Histogram){ 0 };
+
+        Output *other;
+        wl_list_for_each(other, &server->outputs, link) {
+            other->render_time = (Histogram){ 0 };
+            other->present_latency = (Histogram){ 0 };
+            other->missed_vblanks = 0;
+        }
+    }
+
+    server->bench_frames_measured++;
+    server->bench_allocations += allocations;
+    if (allocations > server->bench_allocations_max) server->bench_allocations_max = allocations;
+
+    // Keep repainting once the windows are at rest, idle frames are part of the measurement
+    if (--server->bench_frames == 0) {
+        wl_display_terminate(server->display);
+    } else {
+        wlr_output_schedule_frame(output->base);
+    }
+}
+#endif
+
+void output_repaint(Output *output) {
+    Server *server = output->server;
+    clock_gettime(CLOCK_MONOTONIC, &output->frame_start);
+#ifdef HEADLESS_BENCHMARK
+    uint64_t allocations = bench_allocations();
+#endif
+
+    // Step physics right before sampling it, so a delayed repaint shows the latest state
+    if (server->physics_timer_armed) run_physics_step(server);
+
+    output_render(output);
+
+#ifdef HEADLESS_BENCHMARK
+    bench_record_frame(output, bench_allocations() - allocations);
+#endif
+}
+
+int handle_repaint_timer(void *data) {
+    Output *output = data;
+    output->repaint_pending = false;
+    output_repaint(output);
+    return 0;
+}
+
+// Returns how many milliseconds the repaint can wait and still make the next vblank
+int output_repaint_delay(Output *output) {
+    int max_render_time = output->server->max_render_time;
+    if (max_render_time == 0 || output->refresh_ns <= 0 || output->last_present.tv_sec == 0) return 0;
+
+    uint64_t budget = max_render_time == MAX_RENDER_TIME_AUTO
+        ? output->recent_render_ns + RENDER_TIME_MARGIN_NS
+        : (uint64_t)max_render_time * 1000000;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t now_ns = timespec_to_ns(&now);
+
+    // Predict the next vblank from the last one and the refresh period
+    uint64_t vblank = timespec_to_ns(&output->last_present) + output->refresh_ns;
+    while (vblank <= now_ns) vblank += output->refresh_ns;
+
+    if (vblank < now_ns + budget) return 0;
+    return (vblank - now_ns - budget) / 1000000;
+}
+
+output_listener(frame, data) {
+    // Physics ticks schedule frames too, they must neither push a delayed repaint back nor add a second one
+    if (output->repaint_pending) return;
+
+    int delay = output_repaint_delay(output);
+    if (delay <= 0) {
+        wl_event_source_timer_update(output->repaint_timer, 0);
+        output_repaint(output);
         return;
     }
 
-    frame_destroy(frame);
+    output->repaint_pending = true;
+    wl_event_source_timer_update(output->repaint_timer, delay);
+}
+
+output_listener(present, data) {
+    struct wlr_output_event_present *event = data;
+
+    if (event->presented && event->when != NULL) {
+        output->last_present = *event->when;
+        output->refresh_ns = event->refresh;
+    }
+
+    // Only the frame this output last committed is measured
+    if (!event->presented || event->when == NULL || event->commit_seq != output->commit_seq) return;
+
+    uint64_t presented = timespec_to_ns(event->when);
+    uint64_t committed = timespec_to_ns(&output->commit_time);
+    if (presented < committed) return;
+
+    uint64_t latency = presented - committed;
+    histogram_add(&output->present_latency, latency);
+
+    // Shown later than the vblank following the commit
+    if (event->refresh > 0 && latency > (uint64_t)event->refresh) output->missed_vblanks++;
+}
+
+output_listener(destroy, data) {
+    wl_list_remove(&output->frame.link);
+    wl_list_remove(&output->present.link);
+    wl_list_remove(&output->destroy.link);
+    wl_list_remove(&output->link);
+
+    wl_event_source_remove(output->repaint_timer);
+
+    // Windows of this output move to the world of another one, where they keep falling from the same place
+    Server *server = output->server;
+    Output *other = first_output(server);
+
+    Toplevel *toplevel, *tmp;
+    wl_list_for_each_safe(toplevel, tmp, &output->physics_toplevels, physics_link) {
+        wl_list_remove(&toplevel->physics_link);
+        wl_list_init(&toplevel->physics_link);
+
+        Vector2 pos = GetPhysicsBodyPosition(toplevel->body);
+        float rotation = GetPhysicsBodyOrient(toplevel->body);
+        toplevel->body = NULL;
+        toplevel->output = NULL;
+
+        // Drawn from scratch on the new output, the old box belongs to the destroyed one
+        toplevel->render_box = (struct wlr_box){ 0 };
+        if (other != NULL) toplevel_create_body(toplevel, other, pos, rotation);
+    }
+    DestroyPhysicsWorld(output->world);
+
+    frame_finish(&output->frame);
+    wlr_damage_ring_finish(&output->damage_ring);
+    wl_array_release(&output->quads);
+
+    free(output);
+}
+
+void count_texture_upload(Server *server) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (now.tv_sec != server->texture_uploads_second) {
+        server->texture_uploads_per_second = server->texture_uploads;
+        server->texture_uploads = 0;
+        server->texture_uploads_second = now.tv_sec;
+#if DEBUG
+        log("Texture uploads: %u/s", server->texture_uploads_per_second);
+#endif
+    }
+
+    server->texture_uploads++;
+}
+
+// Picks up the texture of a newly committed buffer, frames in between reuse the cached one
+void toplevel_update_texture(Toplevel *toplevel) {
+    struct wlr_surface *surface = toplevel->base->base->surface;
+
+    // Map is emitted during the commit, the commit listener then sees the same state again
+    if (toplevel->texture != NULL && toplevel->texture_seq == surface->current.seq) return;
+    toplevel->texture_seq = surface->current.seq;
+
+    if (toplevel->texture != NULL && !(surface->current.committed & WLR_SURFACE_STATE_BUFFER)) return;
+
+    toplevel->texture = wlr_surface_get_texture(surface);
+    if (toplevel->texture != NULL) count_texture_upload(toplevel->server);
 }
 
 toplevel_listener(map, data) {
     wl_list_insert(&toplevel->server->toplevels, &toplevel->link);
 
-    struct wlr_surface *surface = toplevel->base->base->surface;
-    struct wlr_texture *texture = wlr_surface_get_texture(surface);
-    toplevel->size.x = texture->width;
-    toplevel->size.y = texture->height;
+    toplevel_update_texture(toplevel);
+    if (toplevel->texture == NULL) return;
+
+    toplevel->size.x = toplevel->texture->width;
+    toplevel->size.y = toplevel->texture->height;
 
-    // Here we have enough information to create a physics object.
-    if (toplevel->body) return;
-    toplevel->body = CreatePhysicsBodyRectangle(toplevel->pos, toplevel->size.x, toplevel->size.y, 1);
-    SetPhysicsBodyRotation(toplevel->body, (float)rand() / RAND_MAX);
+    // Here we have enough information to create a physics object, on the output the window was placed above.
+    Output *output = first_output(toplevel->server);
+    if (toplevel->body || output == NULL) return;
+    toplevel_create_body(toplevel, output, toplevel->pos, (float)rand() / RAND_MAX);
 }
 
 toplevel_listener(unmap, data) {
     wl_list_remove(&toplevel->link);
+    wlr_scene_node_set_enabled(&toplevel->scene_tree->node, false);
+    toplevel->texture = NULL;
+
+    damage_toplevel_output(toplevel, &toplevel->render_box);
+    toplevel->render_box = (struct wlr_box){ 0 };
+}
+
+toplevel_listener(commit, data) {
+    struct wlr_surface *surface = toplevel->base->base->surface;
+
+    if (surface->mapped) toplevel_update_texture(toplevel);
+
+    // Not drawn yet, the first frame after map damages the whole window
+    if (wlr_box_empty(&toplevel->render_box)) return;
+
+    pixman_region32_t damage;
+    pixman_region32_init(&damage);
+    wlr_surface_get_effective_damage(surface, &damage);
+
+    int rects_len;
+    pixman_box32_t *rects = pixman_region32_rectangles(&damage, &rects_len);
+    for (int i = 0; i < rects_len; i++) {
+        struct wlr_box local = {
+            .x = rects[i].x1,
+            .y = rects[i].y1,
+            .width = rects[i].x2 - rects[i].x1,
+            .height = rects[i].y2 - rects[i].y1,
+        };
+        struct wlr_box box = transform_box(&local, toplevel->render_size, toplevel->render_pos, toplevel->render_rotation);
+        damage_toplevel_output(toplevel, &box);
+    }
+
+    pixman_region32_fini(&damage);
+
+    // Clients waiting on a frame callback need a frame event even when nothing was damaged
+    if (toplevel->output != NULL && toplevel_is_visible(toplevel, toplevel->output)) {
+        wlr_output_schedule_frame(toplevel->output->base);
+    }
 }
 
 toplevel_listener(destroy, data) {
     wl_list_remove(&toplevel->map.link);
     wl_list_remove(&toplevel->unmap.link);
+    wl_list_remove(&toplevel->commit.link);
     wl_list_remove(&toplevel->destroy.link);
 
+    wl_list_remove(&toplevel->physics_link);
     DestroyPhysicsBody(toplevel->body);
+    pixman_region32_fini(&toplevel->visible);
+    arm_physics_timer(toplevel->server, true);
 
     free(toplevel);
 }
@@ -456,6 +1455,9 @@ bool handle_keybinding(Server *server, xkb_keysym_t sym) {
         focus_toplevel(toplevel, toplevel->base->base->surface);
         break;
     }
+    case XKB_KEY_F2:
+        log_frame_stats(server);
+        break;
     default:
         return false;
     }
@@ -489,14 +1491,77 @@ keyboard_listener(destroy, data) {
     
 }
 
+void usage(const char *name) {
+#ifdef HEADLESS_BENCHMARK
+    log("Usage: %s [-r off|auto|<milliseconds>] [-n windows] [-f frames]", name);
+    log("  -n  windows opened by the in-process clients, 16 by default");
+    log("  -f  frames measured once every window is mapped, 600 by default");
+#else
+    log("Usage: %s [-r off|auto|<milliseconds>]", name);
+#endif
+    log("  -r  max render time, delays repaints until this long before vblank");
+}
+
 int main(int argc, char** argv) {
     Server server = { 0 };
 
+#ifdef HEADLESS_BENCHMARK
+    server.bench_windows = 16;
+    server.bench_frames = 600;
+    const char *options = "r:n:f:h";
+#else
+    const char *options = "r:h";
+#endif
+
+    int opt;
+    while ((opt = getopt(argc, argv, options)) != -1) {
+        switch (opt) {
+        case 'r':
+            if (strcmp(optarg, "off") == 0) {
+                server.max_render_time = 0;
+            } else if (strcmp(optarg, "auto") == 0) {
+                server.max_render_time = MAX_RENDER_TIME_AUTO;
+            } else {
+                server.max_render_time = atoi(optarg);
+                if (server.max_render_time <= 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+            }
+            break;
+#ifdef HEADLESS_BENCHMARK
+        case 'n':
+            server.bench_windows = atoi(optarg);
+            if (server.bench_windows <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'f':
+            server.bench_frames = atoi(optarg);
+            if (server.bench_frames <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+#endif
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
     server.display = wl_display_create();
 
+#ifdef HEADLESS_BENCHMARK
+    // No GPU nor seat on CI machines, render into shared memory with pixman
+    server.backend = wlr_headless_backend_create(server.display);
+    server.renderer = wlr_pixman_renderer_create();
+#else
     server.backend = wlr_backend_autocreate(server.display, NULL);
 
     server.renderer = wlr_renderer_autocreate(server.backend);
+#endif
     wlr_renderer_init_wl_display(server.renderer, server.display);
 
     // Here we assume that the renderer is gles2
@@ -509,6 +1574,12 @@ int main(int argc, char** argv) {
     wlr_data_device_manager_create(server.display);
 
     server.output_layout = wlr_output_layout_create();
+
+    server.scene = wlr_scene_create();
+    server.scene_layout = wlr_scene_attach_output_layout(server.scene, server.output_layout);
+
+    server.presentation = wlr_presentation_create(server.display, server.backend);
+    wlr_scene_set_presentation(server.scene, server.presentation);
     wl_list_init(&server.outputs);
     server.new_output.notify = server_new_output;
     wl_signal_add(&server.backend->events.new_output, &server.new_output);
@@ -543,23 +1614,67 @@ int main(int argc, char** argv) {
 
     server.seat = wlr_seat_create(server.display, "seat0");
 
+#ifndef HEADLESS_BENCHMARK
     const char *socket = wl_display_add_socket_auto(server.display);
     log("socket: <%s>", socket);
+#endif
 
-    // Set up Physac
-    InitPhysics();
-    SetPhysicsGravity(0, 1);
+    // Set up Physac, every output creates its own world
+    server.physics_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    server.physics_timer = wl_event_loop_add_fd(
+        wl_display_get_event_loop(server.display),
+        server.physics_timer_fd, WL_EVENT_READABLE,
+        handle_physics_timer, &server
+    );
+
+    server.stats_signal = wl_event_loop_add_signal(
+        wl_display_get_event_loop(server.display),
+        SIGUSR1, handle_stats_signal, &server
+    );
 
     wlr_backend_start(server.backend);
+#ifdef HEADLESS_BENCHMARK
+    wlr_headless_add_output(server.backend, 1920, 1080);
+
+    // Clients run on their own thread and talk to the compositor over a socket pair
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        log("Fail to create client socket pair");
+        return 1;
+    }
+    wl_client_create(server.display, fds[0]);
+    bench_start_clients(fds[1], server.bench_windows);
+#else
     // setenv("WAYLAND_DISPLAY", socket, true);
 
     if (fork() == 0) {
         execl("/bin/sh", "/bin/sh", "-c", "WAYLAND_DISPLAY=wayland-0 foot", NULL);
     }
+#endif
 
     wl_display_run(server.display);
 
+#ifdef HEADLESS_BENCHMARK
+    log_frame_stats(&server);
+#ifdef BENCH_COUNT_ALLOCATIONS
+    if (server.bench_frames_measured > 0) {
+        log("Allocations per frame: avg %.1f, max %" PRIu64,
+            (double)server.bench_allocations / server.bench_frames_measured, server.bench_allocations_max);
+    }
+#else
+    log("Allocations per frame: not counted, the C library is not glibc");
+#endif
+#endif
+
     wl_display_destroy_clients(server.display);
+#ifdef HEADLESS_BENCHMARK
+    bench_stop_clients();
+#endif
+
+    wl_event_source_remove(server.stats_signal);
+    wl_event_source_remove(server.physics_timer);
+    close(server.physics_timer_fd);
+
     wlr_output_layout_destroy(server.output_layout);
     wl_display_destroy(server.display);
     
@@ -0,0 +1,229 @@
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// The implementation is compiled into this file, so the benchmark reaches the static solver functions directly
+#define PHYSAC_IMPLEMENTATION
+#define PHYSAC_STANDALONE
+#define PHYSAC_NO_THREADS
+#include <physac.h>
+
+#define log(...) fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n")
+
+// Same world as the compositor, 240 Hz steps with weak gravity in pixels
+#define TIME_STEP_MS (1000.0 / 240)
+#define GRAVITY 1.0f
+
+// Bounds of the scenes, like a 1920x1080 output with its floor and walls
+#define WORLD_WIDTH 1920
+#define WORLD_HEIGHT 1080
+
+// Repetitions of the narrowphase pass over the pairs left in contact
+#define NARROWPHASE_PASSES 1000
+// Overlapping pairs measured at most, more than any scene has
+#define NARROWPHASE_MAX_PAIRS 4096
+
+typedef struct scene {
+    const char *name;
+    void (*create)(PhysicsWorld world);
+} Scene;
+
+typedef struct result {
+    int bodies;
+    unsigned int steps;
+    uint64_t step_ns;
+    uint64_t tested_pairs;
+    uint64_t manifolds;
+    uint64_t iterations;
+    uint64_t narrowphase_pairs;
+    uint64_t narrowphase_ns;
+    int awake;
+    int workers;
+} Result;
+
+uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+void create_bounds(PhysicsWorld world) {
+    PhysicsBody floor = CreatePhysicsBodyRectangle(world, (Vector2){ (float)WORLD_WIDTH / 2, WORLD_HEIGHT }, WORLD_WIDTH, 1, 1);
+    floor->enabled = false;
+
+    PhysicsBody left_wall = CreatePhysicsBodyRectangle(world, (Vector2){ 0, (float)WORLD_HEIGHT / 2 }, 1, WORLD_HEIGHT, 1);
+    left_wall->enabled = false;
+
+    PhysicsBody right_wall = CreatePhysicsBodyRectangle(world, (Vector2){ WORLD_WIDTH, (float)WORLD_HEIGHT / 2 }, 1, WORLD_HEIGHT, 1);
+    right_wall->enabled = false;
+}
+
+// Window sized rectangles dropped on top of each other, slightly shifted so the stack has to balance
+void create_stack(PhysicsWorld world) {
+    create_bounds(world);
+
+    for (int i = 0; i < 12; i++) {
+        float x = (float)WORLD_WIDTH / 2 + (i % 2 ? 8 : -8);
+        float y = WORLD_HEIGHT - 40 - i * 82;
+        CreatePhysicsBodyRectangle(world, (Vector2){ x, y }, 320, 80, 1);
+    }
+}
+
+// 64 boxes of mixed sizes falling as a grid into the same area
+void create_pile(PhysicsWorld world) {
+    create_bounds(world);
+
+    for (int i = 0; i < 64; i++) {
+        float width = 40 + (i * 37) % 60;
+        float height = 40 + (i * 53) % 60;
+        float x = (float)WORLD_WIDTH / 2 - 400 + (i % 8) * 110 + (i / 8 % 2) * 20;
+        float y = 100 + (i / 8) * 110;
+        PhysicsBody body = CreatePhysicsBodyRectangle(world, (Vector2){ x, y }, width, height, 1);
+        SetPhysicsBodyRotation(body, (float)(i % 7) * 0.1f);
+    }
+}
+
+// Circles released row after row above the floor
+void create_rain(PhysicsWorld world) {
+    create_bounds(world);
+
+    for (int i = 0; i < 128; i++) {
+        float x = 200 + (i % 16) * 96 + (i / 16 % 2) * 48;
+        float y = -100 - (i / 16) * 120;
+        CreatePhysicsBodyCircle(world, (Vector2){ x, y }, 20 + i % 3 * 6, 1);
+    }
+}
+
+// 16 separate towers of 10 boxes, every tower is a contact island the workers can solve on their own
+void create_towers(PhysicsWorld world) {
+    create_bounds(world);
+
+    for (int i = 0; i < 160; i++) {
+        float x = 120 + (i % 16) * 112 + (i / 16 % 2 ? 4 : -4);
+        float y = WORLD_HEIGHT - 20 - (i / 16) * 42;
+        CreatePhysicsBodyRectangle(world, (Vector2){ x, y }, 60, 40, 1);
+    }
+}
+
+// Manifolds are rebuilt in the first arena slot for every overlapping pair, like GeneratePhysicsContacts without keeping them
+void measure_narrowphase(PhysicsWorld world, Result *result) {
+    UpdatePhysicsBroadphase(world);
+
+    PhysicsBody pairs[NARROWPHASE_MAX_PAIRS][2];
+    int pairs_count = 0;
+
+    for (int i = 0; i < world->broadphaseBodiesCount && pairs_count < NARROWPHASE_MAX_PAIRS; i++) {
+        PhysicsBody a = world->broadphaseBodies[i];
+        for (int j = i + 1; j < world->broadphaseBodiesCount && pairs_count < NARROWPHASE_MAX_PAIRS; j++) {
+            PhysicsBody b = world->broadphaseBodies[j];
+            if (b->aabb.min.x > a->aabb.max.x) break;
+            if ((b->aabb.min.y > a->aabb.max.y) || (a->aabb.min.y > b->aabb.max.y)) continue;
+            if (!IsPhysicsBodyDynamic(a) && !IsPhysicsBodyDynamic(b)) continue;
+
+            pairs[pairs_count][0] = a;
+            pairs[pairs_count][1] = b;
+            pairs_count++;
+        }
+    }
+
+    world->physicsManifoldsCount = 0;
+
+    uint64_t start = now_ns();
+    for (int pass = 0; pass < NARROWPHASE_PASSES; pass++) {
+        for (int i = 0; i < pairs_count; i++) {
+            PhysicsManifold manifold = CreatePhysicsManifold(pairs[i][0], pairs[i][1]);
+            SolvePhysicsManifold(manifold);
+        }
+    }
+    result->narrowphase_ns = now_ns() - start;
+    result->narrowphase_pairs = (uint64_t)pairs_count * NARROWPHASE_PASSES;
+}
+
+Result run_scene(const Scene *scene, unsigned int steps, bool adaptive, int workers) {
+    Result result = { 0 };
+
+    PhysicsWorld world = CreatePhysicsWorld();
+    SetPhysicsGravity(world, 0, GRAVITY);
+
+    PhysicsSolverSettings settings = GetPhysicsSolverSettings(world);
+    settings.timeStep = TIME_STEP_MS;
+    settings.adaptiveIterations = adaptive;
+    settings.workers = workers;
+    SetPhysicsSolverSettings(world, settings);
+    scene->create(world);
+    result.bodies = GetPhysicsBodiesCount(world);
+
+    // Workers the island solver may use, the pool is sized after the cores of the machine
+    result.workers = workers > 0 && workers < physicsWorkers.workersCount ? workers : physicsWorkers.workersCount;
+    unsigned int iterations = GetPhysicsIterationsCount(world);
+
+    for (unsigned int i = 0; i < steps; i++) {
+        unsigned int steps_count = world->stepsCount;
+
+        uint64_t start = now_ns();
+        PhysicsStep(world);
+        result.step_ns += now_ns() - start;
+
+        // Steps with every body asleep return early, they test no pair
+        if (world->stepsCount == steps_count) continue;
+
+        result.steps++;
+        result.tested_pairs += world->broadphaseBodiesCount * (world->broadphaseBodiesCount - 1) / 2 - world->broadphaseCulledPairs;
+        result.manifolds += world->physicsManifoldsCount;
+    }
+
+    result.iterations = GetPhysicsIterationsCount(world) - iterations;
+    result.awake = GetPhysicsAwakeBodiesCount(world);
+    measure_narrowphase(world, &result);
+
+    DestroyPhysicsWorld(world);
+    return result;
+}
+
+void log_result(const Scene *scene, unsigned int steps, const Result *result) {
+    log("%s: %d bodies, %u steps, %u simulated, %d awake at the end, %d workers", scene->name, result->bodies, steps, result->steps, result->awake, result->workers);
+    log("  steps/s: %.0f, avg step %.3f us", steps / ((double)result->step_ns / 1000000000), (double)result->step_ns / steps / 1000);
+
+    if (result->steps > 0) {
+        log("  pairs/step: %.1f, manifolds/step: %.1f, iterations/step: %.2f, step ns/pair: %.1f",
+            (double)result->tested_pairs / result->steps, (double)result->manifolds / result->steps,
+            (double)result->iterations / result->steps,
+            result->tested_pairs ? (double)result->step_ns / result->tested_pairs : 0.0);
+    }
+
+    if (result->narrowphase_pairs > 0) {
+        log("  narrowphase ns/pair: %.1f over %" PRIu64 " pairs",
+            (double)result->narrowphase_ns / result->narrowphase_pairs, result->narrowphase_pairs / NARROWPHASE_PASSES);
+    }
+}
+
+int main(int argc, char **argv) {
+    const Scene scenes[] = {
+        { "stack", create_stack },
+        { "pile", create_pile },
+        { "rain", create_rain },
+        { "towers", create_towers },
+    };
+
+    // Enough steps for every scene to fall, collide and mostly come to rest
+    unsigned int steps = argc > 1 ? (unsigned int)atoi(argv[1]) : 4000;
+    const char *only = argc > 2 && strcmp(argv[2], "all") != 0 ? argv[2] : NULL;
+    bool adaptive = argc > 3 && strcmp(argv[3], "adaptive") == 0;
+    int workers = argc > 4 ? atoi(argv[4]) : 0;
+    if (steps == 0 || workers < 0) {
+        log("Usage: %s [steps] [all|stack|pile|rain|towers] [fixed|adaptive] [workers]", argv[0]);
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+        if (only != NULL && strcmp(only, scenes[i].name) != 0) continue;
+
+        Result result = run_scene(&scenes[i], steps, adaptive, workers);
+        log_result(&scenes[i], steps, &result);
+    }
+
+    return 0;
+}